@@ -1,17 +1,24 @@
 #include "Actor.h"
 
+#include "ActorPool.h"
+
 #include "AudioDB.h"
 #include "EngineUtils.h"
 #include "ImageDB.h"
 #include "Renderer.h"
+#include "Rigidbody.h"
 #include "SceneDB.h"
+#include "ScriptMemory.h"
+#include "ScriptProfiler.h"
 #include "TemplateDB.h"
 
 #include <algorithm>
 
-// Constructor for Actor, if this is a template, pull from rapidjson value
-Actor::Actor(const rapidjson::Value& doc)
+// Constructor for Actor, if this is a template, pull from rapidjson value. Templates have a null handle
+Actor::Actor(ActorHandle actor_handle, const rapidjson::Value& doc) : handle(actor_handle)
 {
+    ScriptMemory::Scope memory_scope(MEMORY_COMPONENTS);
+
     // Get template if specified
     GetTemplateValues(doc);
 
@@ -19,6 +26,16 @@ Actor::Actor(const rapidjson::Value& doc)
     actor_id = next_id++;
     EngineUtils::GetConfigValue(doc, "name", actor_name);
 
+    // Tags and layer replace the template's when given
+    rapidjson::Value::ConstMemberIterator tag_names = doc.FindMember("tags");
+    if (tag_names != doc.MemberEnd())
+        tags = TagDB::GetTagMask(tag_names->value);
+
+    std::string layer_name;
+    EngineUtils::GetConfigValue(doc, "layer", layer_name);
+    if (!layer_name.empty())
+        layer = TagDB::GetLayer(layer_name);
+
     // Find components, return if not found
     rapidjson::Value::ConstMemberIterator i = doc.FindMember("components");
     if (i == doc.MemberEnd()) { return; }
@@ -27,10 +44,10 @@ Actor::Actor(const rapidjson::Value& doc)
     const rapidjson::Value& components = i->value;
     for (rapidjson::Value::ConstMemberIterator it = components.MemberBegin(); it != components.MemberEnd(); it++)
     {
-        // Get key and create new_component in actor component map
+        // Get key and create new_component in actor component storage
         std::string key = it->name.GetString();
-        bool is_new = actor_components.find(key) == actor_components.end();
-        Component& component = actor_components[key];        
+        bool is_new = FindComponent(key) == nullptr;
+        Component& component = InsertComponent(key);
 
         // Luaref reference
         luabridge::LuaRef& ref = *component.component_ref;
@@ -42,43 +59,83 @@ Actor::Actor(const rapidjson::Value& doc)
 
             ComponentDB::GetComponent(ref, type);
 
-#ifndef NDEBUG
-            if (type == "SpriteRenderer")
-                sprite_renderer_components.push_back(&component);
-#endif
-
             ref["key"] = key;
-            component.type = type;
-
-            type_to_component_key[type].insert(key);
+            component.type_id = ComponentDB::GetTypeID(type);
 
-            component.has_start = ref["OnStart"].isFunction();
-            component.has_update = ref["OnUpdate"].isFunction();
-            component.has_late_update = ref["OnLateUpdate"].isFunction();
-
-            component.has_collision_enter = ref["OnCollisionEnter"].isFunction();
-            component.has_collision_exit = ref["OnCollisionExit"].isFunction();
-            component.has_trigger_enter = ref["OnTriggerEnter"].isFunction();
-            component.has_trigger_exit = ref["OnTriggerExit"].isFunction();
-
-            component.has_destroy = ref["OnDestroy"].isFunction();
+            component.hooks = ComponentDB::GetHooks(type, ref);
+            component.enabled = ComponentDB::GetEnabledFlag(ref, type);
         }
 
         // Set actor attribute in component to actor pointer
-        ref["actor"] = this;
+        ref["actor"] = handle;
 
         // Iterate through all overrides, insert it into lua table
         const rapidjson::Value& values = it->value;
         for (rapidjson::Value::ConstMemberIterator jt = values.MemberBegin(); jt != values.MemberEnd(); jt++)
             EngineUtils::GetComponentOverride(ref, jt->name.GetString(), jt->value);
     }
+
+    RebuildTypeIndex();
 }
 
-// Copy constructor
-Actor::Actor(const Actor& other)
+// Instantiate from a compiled template, script components only need a table, two fields and a shared metatable
+Actor::Actor(ActorHandle actor_handle, const SpawnPlan& plan) : handle(actor_handle)
 {
-    *this = other;
+    ScriptMemory::Scope memory_scope(MEMORY_COMPONENTS);
+
+    const Actor& source = *plan.source;
+    this->plan = &plan;
+
     actor_id = next_id++;
+    actor_name = source.actor_name;
+    tags = source.tags;
+    layer = source.layer;
+    type_index = source.type_index;
+
+    components.reserve(source.components.size());
+
+    // Keep the handle userdata on the stack, every component shares it
+    luabridge::Stack<ActorHandle>::push(lua_state, handle);
+    int handle_index = lua_gettop(lua_state);
+
+    for (size_t i = 0; i < plan.steps.size(); i++)
+    {
+        const SpawnPlan::ComponentStep& step = plan.steps[i];
+        const Component& parent_component = source.components[i];
+
+        if (step.is_cpp)
+        {
+            Component& new_component = components.emplace_back();
+            new_component = parent_component;
+            new_component.key = parent_component.key;
+
+            luabridge::LuaRef& ref = *new_component.component_ref;
+            ref["actor"] = handle;
+            ref["key"] = new_component.key;
+            continue;
+        }
+
+        bool enabled = parent_component.enabled ? *parent_component.enabled : true;
+
+        // Fill the instance before the metatable goes on so the writes stay raw
+        lua_createtable(lua_state, 0, 2);
+        lua_pushvalue(lua_state, handle_index);
+        lua_setfield(lua_state, -2, "actor");
+        lua_pushlstring(lua_state, parent_component.key.data(), parent_component.key.size());
+        lua_setfield(lua_state, -2, "key");
+
+        lua_rawgeti(lua_state, LUA_REGISTRYINDEX, enabled ? step.enabled_metatable : step.disabled_metatable);
+        lua_setmetatable(lua_state, -2);
+        bool* enabled_cell = ComponentDB::NewEnabledCell(-1, enabled);
+
+        Component& new_component = components.emplace_back(luabridge::LuaRef::fromStack(lua_state));
+        new_component.key = parent_component.key;
+        new_component.type_id = parent_component.type_id;
+        new_component.hooks = parent_component.hooks;
+        new_component.enabled = enabled_cell;
+    }
+
+    lua_pop(lua_state, 1);
 }
 
 // Get template if it is specified
@@ -99,287 +156,416 @@ Actor& Actor::operator=(const Actor& other)
     if (this != &other)
     {
         actor_name = other.actor_name;
+        tags = other.tags;
+        layer = other.layer;
 
-        // Iterate through all components and copies to self.
-        for (const auto& [key, parent_component] : other.actor_components)
+        // Iterate through all components and copies to self, other is already sorted by key
+        components.clear();
+        components.reserve(other.components.size());
+        for (const Component& parent_component : other.components)
         {
-            // Get key and create new_component in actor component map
-            Component& new_component = actor_components[key];
+            Component& new_component = components.emplace_back();
 
             new_component = parent_component;
-
-#ifndef NDEBUG
-            if (new_component.type == "SpriteRenderer")
-                sprite_renderer_components.push_back(&new_component);
-#endif
-
-            // create a reference to component_ref
-            type_to_component_key[new_component.type].insert(key);
+            new_component.key = parent_component.key;
 
             luabridge::LuaRef& ref = *new_component.component_ref;
 
             // Set actor attribute in component to actor pointer
-            ref["actor"] = this;
-            ref["key"] = key;
+            ref["actor"] = handle;
+            ref["key"] = new_component.key;
         }
+        RebuildTypeIndex();
     }
     return *this;
 }
 
+// Components that already started on a previous use of a pooled actor get OnReuse instead of OnStart
 void Actor::Start()
 {
-    for (auto& [key, component] : actor_components)
+    for (Component& component : components)
     {
-        if (!component.has_start || !component.alive || !component.IsEnabled())
+        if (!component.alive || !component.IsEnabled())
             continue;
 
-        component.has_start = false;
-
-        try
-        {
-            luabridge::LuaRef& ref = *component.component_ref;
-            ref["OnStart"](ref);
-        }
-        catch (luabridge::LuaException& e)
+        if (component.started)
         {
-            EngineUtils::ReportError(actor_name, e);
+            if (reused && component.HasHook(HOOK_REUSE))
+            {
+                PROFILE_SCRIPT(component, HOOK_REUSE, actor_name);
+                component.Call(HOOK_REUSE, actor_name);
+            }
+            continue;
         }
+
+        component.started = true;
+        if (!component.HasHook(HOOK_START))
+            continue;
+
+        PROFILE_SCRIPT(component, HOOK_START, actor_name);
+        component.Call(HOOK_START, actor_name);
     }
+    reused = false;
+}
+
+// Call a lifecycle function with the number of runs since its last call, used by the scene hook lists
+void Actor::RunHook(Component& component, ComponentHook hook, int frames)
+{
+    PROFILE_SCRIPT(component, hook, actor_name);
+    Renderer::SetDrawingLayer(layer);
+    component.Call(hook, actor_name, frames);
+    Renderer::ClearDrawingLayer();
 }
 
-void Actor::Update()
+void Actor::EditorUpdate()
 {
-    for (auto& [key, component] : actor_components)
+    static const int sprite_renderer_type = ComponentDB::GetTypeID("SpriteRenderer");
+
+    for (Component& component : components)
     {
-        if (!component.has_update || !component.alive || !component.IsEnabled())
+        if (component.type_id != sprite_renderer_type)
+            continue;
+        if (!component.HasHook(HOOK_UPDATE) || !component.alive || !component.IsEnabled())
             continue;
 
-        try
-        {
-            luabridge::LuaRef& ref = *component.component_ref;
-            ref["OnUpdate"](ref);
-        }
-        catch (luabridge::LuaException& e)
-        {
-            EngineUtils::ReportError(actor_name, e);
-        }
+        PROFILE_SCRIPT(component, HOOK_UPDATE, actor_name);
+        Renderer::SetDrawingLayer(layer);
+        component.Call(HOOK_UPDATE, actor_name);
+        Renderer::ClearDrawingLayer();
     }
 }
 
-void Actor::LateUpdate()
+// Move every Rigidbody on this actor to the collision filter of its current layer
+void Actor::RefreshLayer()
 {
-    for (auto& [key, component] : actor_components)
-    {
-        if (!component.has_late_update || !component.alive || !component.IsEnabled())
-            continue;
+    static const int rigidbody_type = ComponentDB::GetTypeID("Rigidbody");
 
-        try
-        {
-            luabridge::LuaRef& ref = *component.component_ref;
-            ref["OnLateUpdate"](ref);
-        }
-        catch (luabridge::LuaException& e)
-        {
-            EngineUtils::ReportError(actor_name, e);
-        }
-    }
+    for (Component& component : components)
+        if (component.type_id == rigidbody_type)
+            component.component_ref->cast<Rigidbody*>()->RefreshLayer();
 }
 
-void Actor::EditorUpdate()
+Rigidbody* Actor::GetRigidbody()
 {
-    for (auto& component : sprite_renderer_components)
-    {
-        if (!component->has_update || !component->alive || !component->IsEnabled())
-            continue;
+    static const int rigidbody_type = ComponentDB::GetTypeID("Rigidbody");
 
-        try
-        {
-            luabridge::LuaRef& ref = *component->component_ref;
-            ref["OnUpdate"](ref);
-        }
-        catch (luabridge::LuaException& e)
-        {
-            EngineUtils::ReportError(actor_name, e);
-        }
-    }
+    for (const TypeSlot& slot : type_index)
+        if (slot.type_id == rigidbody_type)
+            return components[slot.index].component_ref->cast<Rigidbody*>();
+    return nullptr;
 }
 
 void Actor::CollisionEnter(Collision& collision)
 {
-    for (auto& [key, component] : actor_components)
+    if (!(hook_mask & (1u << HOOK_COLLISION_ENTER)))
+        return;
+
+    for (Component& component : components)
     {
-        if (!component.has_collision_enter || !component.alive || !component.IsEnabled())
+        if (!component.HasHook(HOOK_COLLISION_ENTER) || !component.alive || !component.IsEnabled())
             continue;
 
-        try
-        {
-            luabridge::LuaRef& ref = *component.component_ref;
-            ref["OnCollisionEnter"](ref, collision);
-        }
-        catch (luabridge::LuaException& e)
-        {
-            EngineUtils::ReportError(actor_name, e);
-        }
+        PROFILE_SCRIPT(component, HOOK_COLLISION_ENTER, actor_name);
+        component.Call(HOOK_COLLISION_ENTER, actor_name, collision);
     }
 }
 
 void Actor::CollisionExit(Collision& collision)
 {
-    for (auto& [key, component] : actor_components)
+    if (!(hook_mask & (1u << HOOK_COLLISION_EXIT)))
+        return;
+
+    for (Component& component : components)
     {
-        if (!component.has_collision_exit || !component.alive || !component.IsEnabled())
+        if (!component.HasHook(HOOK_COLLISION_EXIT) || !component.alive || !component.IsEnabled())
             continue;
 
-        try
-        {
-            luabridge::LuaRef& ref = *component.component_ref;
-            ref["OnCollisionExit"](ref, collision);
-        }
-        catch (luabridge::LuaException& e)
-        {
-            EngineUtils::ReportError(actor_name, e);
-        }
+        PROFILE_SCRIPT(component, HOOK_COLLISION_EXIT, actor_name);
+        component.Call(HOOK_COLLISION_EXIT, actor_name, collision);
     }
 }
 
 void Actor::TriggerEnter(Collision& collision)
 {
-    for (auto& [key, component] : actor_components)
+    if (!(hook_mask & (1u << HOOK_TRIGGER_ENTER)))
+        return;
+
+    for (Component& component : components)
     {
-        if (!component.has_trigger_enter || !component.alive || !component.IsEnabled())
+        if (!component.HasHook(HOOK_TRIGGER_ENTER) || !component.alive || !component.IsEnabled())
             continue;
 
-        try
-        {
-            luabridge::LuaRef& ref = *component.component_ref;
-            ref["OnTriggerEnter"](ref, collision);
-        }
-        catch (luabridge::LuaException& e)
-        {
-            EngineUtils::ReportError(actor_name, e);
-        }
+        PROFILE_SCRIPT(component, HOOK_TRIGGER_ENTER, actor_name);
+        component.Call(HOOK_TRIGGER_ENTER, actor_name, collision);
     }
 }
 
 void Actor::TriggerExit(Collision& collision)
 {
-    for (auto& [key, component] : actor_components)
+    if (!(hook_mask & (1u << HOOK_TRIGGER_EXIT)))
+        return;
+
+    for (Component& component : components)
     {
-        if (!component.has_trigger_exit || !component.alive || !component.IsEnabled())
+        if (!component.HasHook(HOOK_TRIGGER_EXIT) || !component.alive || !component.IsEnabled())
             continue;
 
-        try
-        {
-            luabridge::LuaRef& ref = *component.component_ref;
-            ref["OnTriggerExit"](ref, collision);
-        }
-        catch (luabridge::LuaException& e)
-        {
-            EngineUtils::ReportError(actor_name, e);
-        }
+        PROFILE_SCRIPT(component, HOOK_TRIGGER_EXIT, actor_name);
+        component.Call(HOOK_TRIGGER_EXIT, actor_name, collision);
     }
 }
 
 void Actor::Destroy()
 {
     alive = false;
-    for (auto& [key, component] : actor_components)
+    for (Component& component : components)
     {
         if (component.alive)
             component.alive = false;
         else
             continue;
-        if (!component.has_destroy)
+
+        SceneDB::UnregisterComponent(&component);
+        if (!component.HasHook(HOOK_DESTROY))
             continue;
 
-        try
+        PROFILE_SCRIPT(component, HOOK_DESTROY, actor_name);
+        component.Call(HOOK_DESTROY, actor_name);
+    }
+}
+
+// Take a pooled actor out of the scene like Destroy, but keep its components for reuse
+void Actor::Release()
+{
+    alive = false;
+    releasing = true;
+    for (Component& component : components)
+    {
+        if (!component.alive)
+            continue;
+
+        component.alive = false;
+        SceneDB::UnregisterComponent(&component);
+    }
+}
+
+// Run OnRelease, invalidate old handles and put every component back to its template state
+void Actor::Park()
+{
+    for (Component& component : components)
+    {
+        if (!component.started || !component.HasHook(HOOK_RELEASE))
+            continue;
+
+        PROFILE_SCRIPT(component, HOOK_RELEASE, actor_name);
+        component.Call(HOOK_RELEASE, actor_name);
+    }
+
+    releasing = false;
+    handle = ActorPool::Reissue(handle);
+
+    tags = plan->source->tags;
+    if (layer != plan->source->layer)
+    {
+        layer = plan->source->layer;
+        RefreshLayer();
+    }
+    components_to_add.clear();
+    components_to_remove.clear();
+
+    luabridge::Stack<ActorHandle>::push(lua_state, handle);
+    int handle_index = lua_gettop(lua_state);
+
+    for (size_t i = 0; i < components.size(); i++)
+    {
+        Component& component = components[i];
+        const Component& parent_component = plan->source->components[i];
+        const SpawnPlan::ComponentStep& step = plan->steps[i];
+
+        bool enabled = parent_component.enabled ? *parent_component.enabled : true;
+        if (component.enabled)
+            *component.enabled = enabled;
+
+        // Parallel components build a new shard instance from the reset table when they run again
+        component.shard_instance.reset();
+
+        // Built-in components keep their fields, OnRelease resets what matters
+        if (step.is_cpp)
         {
-            luabridge::LuaRef& ref = *component.component_ref;
-            ref["OnDestroy"](ref);
+            (*component.component_ref)["actor"] = handle;
+            continue;
         }
-        catch (luabridge::LuaException& e)
+
+        // Clear every field the instance set so lookups fall through to the template again
+        component.component_ref->push(lua_state);
+        int instance_index = lua_gettop(lua_state);
+
+        lua_pushnil(lua_state);
+        while (lua_next(lua_state, instance_index))
         {
-            EngineUtils::ReportError(actor_name, e);
+            lua_pop(lua_state, 1);
+            lua_pushvalue(lua_state, -1);
+            lua_pushnil(lua_state);
+            lua_rawset(lua_state, instance_index);
         }
+
+        lua_pushliteral(lua_state, "actor");
+        lua_pushvalue(lua_state, handle_index);
+        lua_rawset(lua_state, instance_index);
+        lua_pushliteral(lua_state, "key");
+        lua_pushlstring(lua_state, component.key.data(), component.key.size());
+        lua_rawset(lua_state, instance_index);
+
+        lua_rawgeti(lua_state, LUA_REGISTRYINDEX, enabled ? step.enabled_metatable : step.disabled_metatable);
+        lua_setmetatable(lua_state, instance_index);
+        lua_pop(lua_state, 1);
     }
+
+    lua_pop(lua_state, 1);
+}
+
+// Bring a parked actor back as a new actor, it starts again on the next frame
+void Actor::Reuse()
+{
+    actor_id = next_id++;
+    alive = true;
+    reused = true;
+    hook_mask = 0;
+
+    for (Component& component : components)
+        component.alive = true;
 }
 
 void Actor::ProcessAddedComponents()
 {
-    for (Component& c : components_to_add)
+    if (components_to_add.empty())
+        return;
+
+    // OnStart may queue more components, those wait for the next frame
+    std::deque<Component> added;
+    std::swap(added, components_to_add);
+
+    // Insert in one pass so the storage only moves once
+    std::vector<std::string> added_keys;
+    for (Component& c : added)
     {
         if (!c.alive)
             continue;
-        
-        luabridge::LuaRef& ref = *c.component_ref;
-        if (c.has_start && c.IsEnabled())
+
+        added_keys.push_back(c.key);
+        std::string key = c.key;
+        InsertComponent(key) = std::move(c);
+    }
+
+    RelocateComponents();
+    for (const std::string& key : added_keys)
+        SceneDB::RegisterComponent(this, FindComponent(key));
+
+    RebuildTypeIndex();
+    RefreshHookMask();
+
+    // Started after the insert, so every OnStart can find and remove the components added with it
+    for (const std::string& key : added_keys)
+    {
+        Component* c = FindComponent(key);
+        if (c && c->alive && !c->started && c->HasHook(HOOK_START) && c->IsEnabled())
         {
-            c.has_start = false;
-        
-            try
-            {
-                ref["OnStart"](ref);
-            }
-            catch (luabridge::LuaException& e)
-            {
-                EngineUtils::ReportError(actor_name, e);
-            }
+            c->started = true;
+
+            PROFILE_SCRIPT(*c, HOOK_START, actor_name);
+            c->Call(HOOK_START, actor_name);
         }
-        actor_components[ref["key"]] = std::move(c);
     }
-    components_to_add.clear();
 }
 
-// Do OnDestroy for all removed components
+// Do OnDestroy for all removed components, then drop them from storage
 void Actor::ProcessRemovedComponents()
 {
-    for (Component* c : components_to_remove)
+    if (components_to_remove.empty())
+        return;
+
+    for (const std::string& key : components_to_remove)
     {
-        luabridge::LuaRef& ref = *c->component_ref;
-        if (c->has_destroy)
+        Component* c = FindComponent(key);
+        if (c && c->HasHook(HOOK_DESTROY))
         {
-            try
-            {
-                ref["OnDestroy"](ref);
-            }
-            catch (luabridge::LuaException& e)
-            {
-                EngineUtils::ReportError(actor_name, e);
-            }
+            PROFILE_SCRIPT(*c, HOOK_DESTROY, actor_name);
+            c->Call(HOOK_DESTROY, actor_name);
         }
     }
     components_to_remove.clear();
+
+    // Removed components are already unregistered, but the survivors may shift
+    components.erase(std::remove_if(components.begin(), components.end(),
+        [](const Component& c) { return !c.alive; }), components.end());
+
+    RelocateComponents();
+    RebuildTypeIndex();
+    RefreshHookMask();
+}
+
+// Collect which lifecycle functions any live component implements
+void Actor::RefreshHookMask()
+{
+    hook_mask = 0;
+    for (Component& component : components)
+    {
+        if (!component.alive)
+            continue;
+
+        for (int hook = 0; hook < HOOK_COUNT; hook++)
+            if (component.HasHook(static_cast<ComponentHook>(hook)))
+                hook_mask |= 1u << hook;
+    }
 }
 
 // Return LuaRef to actor component from component key
 luabridge::LuaRef Actor::GetComponentByKey(const std::string& key)
 {
-    auto it = actor_components.find(key);
-    if (it == actor_components.end() || !it->second.alive)
+    Component* component = FindComponent(key);
+    if (component == nullptr || !component->alive)
         return luabridge::LuaRef(lua_state);
-    return *it->second.component_ref;
+    return *component->component_ref;
 }
 
 // Return LuaRef to first actor component from type name
 luabridge::LuaRef Actor::GetComponent(const std::string& type_name)
 {
-    // Dead components will not be in type_to_component
-    auto it = type_to_component_key.find(type_name);
-    if (it != type_to_component_key.end() && !it->second.empty())
-        return *actor_components[*it->second.begin()].component_ref;
+    int type_id = ComponentDB::FindTypeID(type_name);
+    if (type_id == -1)
+        return luabridge::LuaRef(lua_state);
+
+    for (const TypeSlot& slot : type_index)
+        if (slot.type_id == type_id)
+            return *components[slot.index].component_ref;
+
+    // Fall back to components added this frame
+    for (Component& component : components_to_add)
+        if (component.type_id == type_id && component.alive)
+            return *component.component_ref;
+
     return luabridge::LuaRef(lua_state);
 }
 
 // Return LuaRef to table of all actor components of type name
 luabridge::LuaRef Actor::GetComponents(const std::string& type_name)
 {
+    ScriptMemory::Scope memory_scope(MEMORY_RESULTS);
+
     luabridge::LuaRef table = luabridge::newTable(lua_state);
     int i = 1;
 
-    auto it = type_to_component_key.find(type_name);
-    if (it != type_to_component_key.end())
-        for (const std::string& key : it->second)
-            table[i++] = *actor_components[key].component_ref;
+    int type_id = ComponentDB::FindTypeID(type_name);
+    if (type_id == -1)
+        return table;
+
+    for (Component& component : components)
+        if (component.type_id == type_id && component.alive)
+            table[i++] = *component.component_ref;
+
+    for (Component& component : components_to_add)
+        if (component.type_id == type_id && component.alive)
+            table[i++] = *component.component_ref;
 
     return table;
 }
@@ -387,41 +573,33 @@ luabridge::LuaRef Actor::GetComponents(const std::string& type_name)
 // Queue component for initialization
 luabridge::LuaRef Actor::AddComponent(const std::string& type_name)
 {
-    // Get key and create new_component in actor component map
+    ScriptMemory::Scope memory_scope(MEMORY_COMPONENTS);
+
+    // Get key that no stored or queued component uses
     std::string key = "r" + std::to_string(next_component++);
-    
-    while (actor_components.find(key) != actor_components.end())
+
+    while (FindComponent(key) != nullptr)
         key = "r" + std::to_string(next_component++);
 
     Component& component = components_to_add.emplace_back();
 
     // create a reference to component_ref
     luabridge::LuaRef& ref = *component.component_ref;
-    
+
     // Get component_ref
     ComponentDB::GetComponent(ref, type_name);
 
-    component.has_start = ref["OnStart"].isFunction();
-    component.has_update = ref["OnUpdate"].isFunction();
-    component.has_late_update = ref["OnLateUpdate"].isFunction();
-
-    component.has_collision_enter = ref["OnCollisionEnter"].isFunction();
-    component.has_collision_exit = ref["OnCollisionExit"].isFunction();
-    component.has_trigger_enter = ref["OnTriggerEnter"].isFunction();
-    component.has_trigger_exit = ref["OnTriggerExit"].isFunction();
-
-    component.has_destroy = ref["OnDestroy"].isFunction();
+    component.hooks = ComponentDB::GetHooks(type_name, ref);
+    component.enabled = ComponentDB::GetEnabledFlag(ref, type_name);
 
     // Set actor attribute in component to actor pointer
-    ref["actor"] = this;
+    ref["actor"] = handle;
     ref["key"] = key;
-    component.type = type_name;
-    type_to_component_key[type_name].insert(key);
+    component.key = key;
+    component.type_id = ComponentDB::GetTypeID(type_name);
 
-#ifndef NDEBUG
-    if (type_name == "SpriteRenderer")
-        sprite_renderer_components.push_back(&component);
-#endif
+    if (alive)
+        SceneDB::QueueAddedComponents(this);
 
     return *component.component_ref;
 }
@@ -431,12 +609,77 @@ void Actor::RemoveComponent(luabridge::LuaRef victim_ref)
 {
     // Get key and reference of victim
     std::string key = victim_ref["key"];
-    Component& victim = actor_components[key];
-
-    // Mark component as not dead and disable component
-    victim.alive = false;
-    
-    // Remove victim from type_vector 
-    type_to_component_key[victim.type].erase(key);
-    components_to_remove.push_back(&victim);
+    Component* victim = FindComponent(key);
+
+    // Components added this frame have not started, drop them before they do
+    if (victim == nullptr)
+    {
+        for (Component& component : components_to_add)
+            if (component.key == key)
+                component.alive = false;
+        return;
+    }
+
+    if (!victim->alive)
+        return;
+
+    // Mark component as dead and stop dispatching to it
+    victim->alive = false;
+    SceneDB::UnregisterComponent(victim);
+
+    RebuildTypeIndex();
+    components_to_remove.push_back(key);
+
+    if (alive)
+        SceneDB::QueueRemovedComponents(this);
+}
+
+// Binary search the sorted storage, nullptr if the key is not stored
+Component* Actor::FindComponent(const std::string& key)
+{
+    auto it = std::lower_bound(components.begin(), components.end(), key,
+        [](const Component& c, const std::string& k) { return c.key < k; });
+    if (it == components.end() || it->key != key)
+        return nullptr;
+    return &*it;
+}
+
+// Return the component stored under key, inserting an empty one in order if there is none.
+// Insertion moves components, callers that registered them must call RelocateComponents
+Component& Actor::InsertComponent(const std::string& key)
+{
+    auto it = std::lower_bound(components.begin(), components.end(), key,
+        [](const Component& c, const std::string& k) { return c.key < k; });
+    if (it != components.end() && it->key == key)
+        return *it;
+
+    it = components.emplace(it);
+    it->key = key;
+    return *it;
+}
+
+// Record the first live component of each type, components are visited in key order
+void Actor::RebuildTypeIndex()
+{
+    type_index.clear();
+    for (int i = 0; i < static_cast<int>(components.size()); i++)
+    {
+        const Component& component = components[i];
+        if (!component.alive)
+            continue;
+
+        bool seen = false;
+        for (const TypeSlot& slot : type_index)
+            seen |= slot.type_id == component.type_id;
+
+        if (!seen)
+            type_index.push_back({ component.type_id, i });
+    }
+}
+
+// Refresh the scene hook lists after the storage moved
+void Actor::RelocateComponents()
+{
+    for (Component& component : components)
+        SceneDB::RelocateComponent(&component);
 }
@@ -1,28 +1,30 @@
 #ifndef ACTOR_H
 #define ACTOR_H
 
+#include "ActorHandle.h"
 #include "CollisionDetector.h"
 #include "ComponentManager.h"
+#include "TagDB.h"
 
 #include "rapidjson/document.h"
 
 #include <iostream>
 #include <string>
-#include <map>
-#include <set>
-#include <unordered_map>
+#include <deque>
+#include <vector>
 
 class Collision;
+class Rigidbody;
+struct SpawnPlan;
 
 class Actor
 {
 public:
-	Actor(const rapidjson::Value& doc);
-	Actor(const Actor& other);
+	Actor(ActorHandle actor_handle, const rapidjson::Value& doc);
+	Actor(ActorHandle actor_handle, const SpawnPlan& plan);
 
 	void Start();
-	void Update();
-	void LateUpdate();
+	void RunHook(Component& component, ComponentHook hook, int frames);
 
 	void EditorUpdate();
 
@@ -32,13 +34,27 @@ public:
 	void TriggerExit(Collision& collision);
 
 	void Destroy();
+	void Release();
+	void Park();
+	void Reuse();
 
 	void ProcessAddedComponents();
 	void ProcessRemovedComponents();
+	void RefreshHookMask();
 
 	// Identifier getters
 	std::string& GetName() { return actor_name; }
 	int GetID() const { return actor_id; }
+	ActorHandle GetHandle() const { return handle; }
+	bool IsAlive() const { return alive; }
+
+	// Tag bits and layer index, interned by TagDB
+	uint32_t GetTags() const { return tags; }
+	int GetLayer() const { return layer; }
+	void RefreshLayer();
+
+	// First started Rigidbody component, nullptr if there is none
+	Rigidbody* GetRigidbody();
 
 	// Component getters
 	luabridge::LuaRef GetComponentByKey(const std::string& key);
@@ -56,24 +72,65 @@ private:
 	// Identifiers
 	static inline int next_id = 0;
 	int actor_id;
+	ActorHandle handle;
 	std::string actor_name = "";
 
-	// Component storage
-	std::map<std::string, Component> actor_components;
-	std::unordered_map<std::string, std::set<std::string>> type_to_component_key;
-	std::vector<Component*> sprite_renderer_components;
+	uint32_t tags = 0;
+	int layer = 0;
+
+	// Position in SceneDB's per tag and per layer lists, layer_slot is -1 while the actor is not listed
+	int tag_slots[TagDB::MAX_TAGS];
+	int layer_slot = -1;
+
+	// Entry in SceneDB's spatial grid, -1 while the actor has no position
+	int spatial_slot = -1;
+
+	// Compiled template this actor was instantiated from, nullptr for scene actors
+	const SpawnPlan* plan = nullptr;
+
+	// Component storage, sorted by key
+	std::vector<Component> components;
+
+	// First live component of each type, by interned type id
+	struct TypeSlot
+	{
+		int type_id;
+		int index;
+	};
+	std::vector<TypeSlot> type_index;
+
+	Component* FindComponent(const std::string& key);
+	Component& InsertComponent(const std::string& key);
+	void RebuildTypeIndex();
+	void RelocateComponents();
+
+	// Bit per ComponentHook, set when any live component implements it
+	uint32_t hook_mask = 0;
 
 	// Deletion markers
 	bool alive = true;
 	bool retain = false;
 
+	// Pooling markers, released actors wait to be parked and reused actors run OnReuse on start
+	bool releasing = false;
+	bool reused = false;
+
+	// Position in SceneDB::loaded_actors, -1 while the actor is not in the scene
+	int scene_index = -1;
+
+	// Set while the actor waits in one of SceneDB's component change lists
+	bool queued_added_components = false;
+	bool queued_removed_components = false;
+
 	// Component creation and deletion
 	static inline int next_component = 0;
 	std::deque<Component> components_to_add;
-	std::vector<Component*> components_to_remove;
+	std::vector<std::string> components_to_remove;
 
 	friend class SceneDB;
 	friend class EditorManager;
+	friend class TemplateDB;
+	friend class SpatialGrid;
 };
 
 #endif
@@ -0,0 +1,19 @@
+#ifndef ACTOR_HANDLE_H
+#define ACTOR_HANDLE_H
+
+#include <cstdint>
+
+// Generational reference to a pooled actor. Scripts only ever hold these,
+// so a handle to a reclaimed actor resolves to nullptr instead of dangling.
+struct ActorHandle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    // Generation 0 is never issued, a default handle refers to nothing
+    explicit operator bool() const { return generation != 0; }
+    bool operator==(const ActorHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const ActorHandle& other) const { return !(*this == other); }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "ActorPool.h"
+
+#include "TemplateDB.h"
+
+#include <new>
+
+// Construct a scene actor from json in a free slot
+Actor* ActorPool::Create(const rapidjson::Value& doc)
+{
+    ActorHandle handle = Allocate();
+    return new (GetSlot(handle.index).storage) Actor(handle, doc);
+}
+
+// Construct a scene actor from a compiled template in a free slot
+Actor* ActorPool::Create(const SpawnPlan& plan)
+{
+    ActorHandle handle = Allocate();
+    return new (GetSlot(handle.index).storage) Actor(handle, plan);
+}
+
+// Destroy the actor and return its slot, handles to it resolve to nullptr from now on
+void ActorPool::Release(Actor* actor)
+{
+    ActorHandle handle = actor->GetHandle();
+    Slot& slot = GetSlot(handle.index);
+    if (!slot.occupied || slot.generation != handle.generation)
+        return;
+
+    actor->~Actor();
+    slot.occupied = false;
+
+    // Skip 0 on wrap so default handles stay invalid
+    if (++slot.generation == 0)
+        slot.generation = 1;
+
+    free_slots.push_back(handle.index);
+    live_count--;
+}
+
+// Keep the actor in its slot but give it a new generation, outstanding handles to it go stale
+ActorHandle ActorPool::Reissue(ActorHandle handle)
+{
+    Slot& slot = GetSlot(handle.index);
+    if (++slot.generation == 0)
+        slot.generation = 1;
+
+    return { handle.index, slot.generation };
+}
+
+// Return the live actor a handle refers to, nullptr if it was released
+Actor* ActorPool::Resolve(ActorHandle handle)
+{
+    if (!handle || handle.index >= Capacity())
+        return nullptr;
+
+    Slot& slot = GetSlot(handle.index);
+    if (!slot.occupied || slot.generation != handle.generation)
+        return nullptr;
+
+    return slot.Get();
+}
+
+// Reserve a slot, reusing the most recently released one so its memory is still warm
+ActorHandle ActorPool::Allocate()
+{
+    if (free_slots.empty())
+    {
+        uint32_t first = static_cast<uint32_t>(Capacity());
+        chunks.push_back(std::make_unique<Slot[]>(CHUNK_SIZE));
+
+        // Push in reverse so slots are handed out in address order
+        for (uint32_t i = CHUNK_SIZE; i > 0; i--)
+            free_slots.push_back(first + i - 1);
+    }
+
+    uint32_t index = free_slots.back();
+    free_slots.pop_back();
+
+    Slot& slot = GetSlot(index);
+    slot.occupied = true;
+    live_count++;
+
+    return { index, slot.generation };
+}
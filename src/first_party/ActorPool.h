@@ -0,0 +1,48 @@
+#ifndef ACTOR_POOL_H
+#define ACTOR_POOL_H
+
+#include "Actor.h"
+#include "ActorHandle.h"
+
+#include "rapidjson/document.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Slab allocator for scene actors. Slots live in fixed-size chunks so actors never move,
+// and each slot's generation is bumped on release to invalidate outstanding handles.
+class ActorPool
+{
+public:
+    static Actor* Create(const rapidjson::Value& doc);
+    static Actor* Create(const SpawnPlan& plan);
+    static void Release(Actor* actor);
+    static ActorHandle Reissue(ActorHandle handle);
+
+    static Actor* Resolve(ActorHandle handle);
+
+    static size_t LiveCount() { return live_count; }
+    static size_t Capacity() { return chunks.size() * CHUNK_SIZE; }
+
+private:
+    static inline const uint32_t CHUNK_SIZE = 256;
+
+    struct Slot
+    {
+        alignas(Actor) unsigned char storage[sizeof(Actor)];
+        uint32_t generation = 1;
+        bool occupied = false;
+
+        Actor* Get() { return reinterpret_cast<Actor*>(storage); }
+    };
+
+    static ActorHandle Allocate();
+    static Slot& GetSlot(uint32_t index) { return chunks[index / CHUNK_SIZE][index % CHUNK_SIZE]; }
+
+    static inline std::vector<std::unique_ptr<Slot[]>> chunks;
+    static inline std::vector<uint32_t> free_slots;
+    static inline size_t live_count = 0;
+};
+
+#endif
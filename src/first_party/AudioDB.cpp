@@ -1,5 +1,7 @@
 #include "AudioDB.h"
 
+#include "Engine.h"
+
 
 // Open audio channels and make allocate
 void AudioDB::Init()
@@ -11,6 +13,10 @@ void AudioDB::Init()
 // Play a sound on channel
 int AudioDB::PlayChannel(int channel, const std::string& audio_name, bool looping)
 {
+    // Mixer is never opened when headless
+    if (Engine::headless)
+        return channel;
+
     if (looping)
         return AudioHelper::Mix_PlayChannel(channel, GetAudio(audio_name), -1);
     return AudioHelper::Mix_PlayChannel(channel, GetAudio(audio_name), 0);
@@ -19,12 +25,18 @@ int AudioDB::PlayChannel(int channel, const std::string& audio_name, bool loopin
 // Halt sound playing on channel
 int AudioDB::HaltChannel(int channel)
 {
+    if (Engine::headless)
+        return 0;
+
     return AudioHelper::Mix_HaltChannel(channel);
 }
 
 // Halt sound playing on channel
 int AudioDB::SetVolume(int channel, int volume)
 {
+    if (Engine::headless)
+        return 0;
+
     return AudioHelper::Mix_Volume(channel, volume);
 }
 
@@ -11,7 +11,7 @@ void CollisionDetector::BeginContact(b2Contact* contact)
     contact->GetWorldManifold(&world_manifold);
     Collision collision;
 
-    collision.other = actor_b;
+    collision.other = actor_b->GetHandle();
     collision.point = world_manifold.points[0];
     collision.relative_velocity = fixture_a->GetBody()->GetLinearVelocity() - fixture_b->GetBody()->GetLinearVelocity();
     collision.normal = world_manifold.normal;
@@ -22,14 +22,14 @@ void CollisionDetector::BeginContact(b2Contact* contact)
         collision.normal = SENTINEL;
 
         actor_a->TriggerEnter(collision);
-        collision.other = actor_a;
+        collision.other = actor_a->GetHandle();
 
         actor_b->TriggerEnter(collision);
     }
     else if (!fixture_a->IsSensor() && !fixture_b->IsSensor())
     {
         actor_a->CollisionEnter(collision);
-        collision.other = actor_a;
+        collision.other = actor_a->GetHandle();
 
         actor_b->CollisionEnter(collision);
     }
@@ -46,7 +46,7 @@ void CollisionDetector::EndContact(b2Contact* contact)
     contact->GetWorldManifold(&world_manifold);
     Collision collision;
 
-    collision.other = actor_b;
+    collision.other = actor_b->GetHandle();
     collision.point = SENTINEL;
     collision.relative_velocity = fixture_a->GetBody()->GetLinearVelocity() - fixture_b->GetBody()->GetLinearVelocity();
     collision.normal = SENTINEL;
@@ -54,15 +54,23 @@ void CollisionDetector::EndContact(b2Contact* contact)
     if (fixture_a->IsSensor() && fixture_b->IsSensor())
     {
         actor_a->TriggerExit(collision);
-        collision.other = actor_a;
+        collision.other = actor_a->GetHandle();
 
         actor_b->TriggerExit(collision);
     }
     else if (!fixture_a->IsSensor() && !fixture_b->IsSensor())
     {
         actor_a->CollisionExit(collision);
-        collision.other = actor_a;
+        collision.other = actor_a->GetHandle();
 
         actor_b->CollisionExit(collision);
     }
 }
+
+bool CollisionFilter::ShouldCollide(b2Fixture* fixture_a, b2Fixture* fixture_b)
+{
+    if (fixture_a->IsSensor() != fixture_b->IsSensor())
+        return false;
+
+    return b2ContactFilter::ShouldCollide(fixture_a, fixture_b);
+}
@@ -2,6 +2,7 @@
 #define COLLISION_DETECTOR_H
 
 #include "Actor.h"
+#include "ActorHandle.h"
 
 #include "box2d/box2d.h"
 
@@ -14,10 +15,16 @@ class CollisionDetector : public b2ContactListener
     void EndContact(b2Contact* contact) override;
 };
 
+// Layer masks decide contacts, and colliders never touch triggers
+class CollisionFilter : public b2ContactFilter
+{
+    bool ShouldCollide(b2Fixture* fixture_a, b2Fixture* fixture_b) override;
+};
+
 class Collision
 {
 public:
-    Actor* other = nullptr;
+    ActorHandle other;
     b2Vec2 point;
     b2Vec2 relative_velocity;
     b2Vec2 normal;
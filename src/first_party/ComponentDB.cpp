@@ -1,47 +1,384 @@
 #include "ComponentDB.h"
 
+#include "EngineUtils.h"
 #include "Rigidbody.h"
 #include "ParticleSystem.h"
+#include "ScriptMemory.h"
+#include "ScriptShards.h"
 
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
 
-// Add all lua files in folder to database
+// Find the lua files in the component folder without running them. Types load the first time they are used,
+// or right away if resources/preload.config lists them: { "component_types": ["PlayerController", ...] }
 void ComponentDB::Init()
 {
-    const std::string directory_path = "resources/component_types";
-    if (std::filesystem::exists(directory_path))
+    script_paths.clear();
+    if (std::filesystem::exists(COMPONENT_DIRECTORY))
     {
-        // Check lua scripts and add them to the global state as tables
-        for (const auto& file : std::filesystem::directory_iterator(directory_path))
+        for (const auto& file : std::filesystem::directory_iterator(COMPONENT_DIRECTORY))
         {
-            std::string component_name = file.path().stem().string();
-            if (luaL_dofile(lua_state, file.path().string().c_str()) != LUA_OK)
+            if (file.path().extension() == ".lua")
+                script_paths[file.path().stem().string()] = file.path().string();
+        }
+    }
+
+    // Scripts that use another component type's table as a global still find it
+    lua_pushglobaltable(lua_state);
+    lua_createtable(lua_state, 0, 1);
+    lua_pushcfunction(lua_state, &GlobalIndex);
+    lua_setfield(lua_state, -2, "__index");
+    lua_setmetatable(lua_state, -2);
+    lua_pop(lua_state, 1);
+
+    if (std::filesystem::exists(PRELOAD_MANIFEST))
+    {
+        rapidjson::Document doc;
+        EngineUtils::ReadJsonFile(PRELOAD_MANIFEST, doc);
+        if (doc.HasMember("component_types") && doc["component_types"].IsArray())
+        {
+            for (const rapidjson::Value& name : doc["component_types"].GetArray())
             {
-                std::cout << "problem with lua file " << component_name;
-                exit(0);
-            }
-            
-            // Get unique_ptr to LuaState, add it to map
-            loaded_components.insert(
+                if (!name.IsString() || !FindType(name.GetString()))
                 {
-                    component_name,
-                    std::make_unique<luabridge::LuaRef>(luabridge::getGlobal(lua_state, component_name.c_str()))
-                });
+                    std::cout << "error: " << PRELOAD_MANIFEST << " lists a component type with no script";
+                    exit(0);
+                }
+            }
         }
     }
 }
 
+// Forget every loaded type, so the next use of each runs its current script. The shards forget theirs too
+void ComponentDB::ResetDatabase()
+{
+    loaded_components.clear();
+    hook_cache.clear();
+    default_refs.clear();
+    parent_metatables.reset();
+    enabled_cells.reset();
+    ScriptShards::ResetTypes();
+}
+
 std::vector<std::string>& ComponentDB::GetKeys(const std::string& component_type)
+{
+    luabridge::LuaRef* type_table = FindType(component_type);
+    if (type_table)
+    {
+        return FindKeys(*type_table);
+    }
+    else
+    {
+        return FindKeysCpp(component_type);
+    }
+}
+
+// Return a component type's table, running its script the first time. nullptr if the type has no script
+luabridge::LuaRef* ComponentDB::FindType(const std::string& component_type)
 {
     auto it = loaded_components.find(component_type);
     if (it != loaded_components.end())
+        return it->second.get();
+
+    if (script_paths.count(component_type) == 0)
+        return nullptr;
+
+    ScriptMemory::Scope memory_scope(MEMORY_COMPONENTS);
+
+    // Registered before the script runs, so a script that reads its own global does not load itself again
+    std::unique_ptr<luabridge::LuaRef>& type_table = loaded_components[component_type];
+    type_table = std::make_unique<luabridge::LuaRef>(lua_state);
+
+    if (LoadScript(lua_state, component_type) != LUA_OK || lua_pcall(lua_state, 0, 0, 0) != LUA_OK)
     {
-        return FindKeys(*it->second.get());
+        std::cout << "problem with lua file " << component_type;
+        exit(0);
+    }
+
+    *type_table = luabridge::getGlobal(lua_state, component_type.c_str());
+    if (type_table->isTable())
+    {
+        type_table->push(lua_state);
+        default_refs[component_type] = RefDefaults(lua_state, -1);
+        lua_pop(lua_state, 1);
     }
+    return type_table.get();
+}
+
+// Merge a changed script into its type if the type is loaded, and refresh the type's cached hooks in place
+// since components point at them. False if there was nothing to merge into or the script failed
+bool ComponentDB::Reload(const std::string& component_type)
+{
+    if (loaded_components.count(component_type) == 0)
+        return false;
+
+    ScriptMemory::Scope memory_scope(MEMORY_COMPONENTS);
+    int& defaults_ref = default_refs.try_emplace(component_type, LUA_NOREF).first->second;
+    if (!MergeScript(lua_state, component_type, defaults_ref))
+        return false;
+
+    auto it = hook_cache.find(component_type);
+    if (it != hook_cache.end())
+    {
+        loaded_components[component_type]->push(lua_state);
+        ReadHooks(component_type, it->second, true);
+        lua_pop(lua_state, 1);
+    }
+    return true;
+}
+
+// Run a script again in L and merge the table it makes into the type table already there, which instances
+// inherit from, so they keep their state. Functions are replaced or removed along with the script's, and other
+// fields take the new value unless the game has set them since the last load. A failing script is reported
+// and leaves the type as it was
+bool ComponentDB::MergeScript(lua_State* L, const std::string& component_type, int& defaults_ref)
+{
+    lua_getglobal(L, component_type.c_str());
+    int live = lua_absindex(L, -1);
+    if (!lua_istable(L, live))
+    {
+        lua_pop(L, 1);
+        return false;
+    }
+
+    int status = LoadScript(L, component_type);
+    if (status == LUA_OK)
+        status = lua_pcall(L, 0, 0, 0);
+    if (status != LUA_OK)
+    {
+        const char* message = lua_tostring(L, -1);
+        EngineUtils::ReportError(component_type, message ? message : "script failed to reload");
+        lua_pop(L, 2);
+        return false;
+    }
+
+    // The global goes back to the live table whatever the script did with it
+    lua_getglobal(L, component_type.c_str());
+    int fresh = lua_absindex(L, -1);
+    lua_pushvalue(L, live);
+    lua_setglobal(L, component_type.c_str());
+    if (!lua_istable(L, fresh))
+    {
+        EngineUtils::ReportError(component_type, "script no longer makes a table named " + component_type);
+        lua_pop(L, 2);
+        return false;
+    }
+
+    if (defaults_ref == LUA_NOREF)
+        lua_newtable(L);
     else
+        lua_rawgeti(L, LUA_REGISTRYINDEX, defaults_ref);
+    int defaults = lua_absindex(L, -1);
+
+    lua_pushnil(L);
+    while (lua_next(L, fresh))
     {
-        return FindKeysCpp(component_type);
+        bool replace = lua_isfunction(L, -1);
+        if (!replace)
+        {
+            lua_pushvalue(L, -2);
+            lua_rawget(L, live);
+            lua_pushvalue(L, -3);
+            lua_rawget(L, defaults);
+            replace = lua_isnil(L, -2) || lua_rawequal(L, -2, -1);
+            lua_pop(L, 2);
+        }
+
+        if (replace)
+        {
+            lua_pushvalue(L, -2);
+            lua_pushvalue(L, -2);
+            lua_rawset(L, live);
+        }
+        lua_pop(L, 1);
+    }
+
+    // Drop what the script no longer sets, clearing fields while traversing is allowed
+    lua_pushnil(L);
+    while (lua_next(L, live))
+    {
+        lua_pushvalue(L, -2);
+        lua_rawget(L, fresh);
+        bool removed = lua_isnil(L, -1);
+        lua_pop(L, 1);
+
+        if (removed && !lua_isfunction(L, -1))
+        {
+            lua_pushvalue(L, -2);
+            lua_rawget(L, defaults);
+            removed = lua_rawequal(L, -2, -1);
+            lua_pop(L, 1);
+        }
+
+        if (removed)
+        {
+            lua_pushvalue(L, -2);
+            lua_pushnil(L);
+            lua_rawset(L, live);
+        }
+        lua_pop(L, 1);
+    }
+
+    // Types that inherit through their own metatable follow the new one
+    if (lua_getmetatable(L, fresh))
+        lua_setmetatable(L, live);
+
+    luaL_unref(L, LUA_REGISTRYINDEX, defaults_ref);
+    defaults_ref = RefDefaults(L, fresh);
+    lua_pop(L, 3);
+    return true;
+}
+
+// Pin a copy of the fields other than functions of the type table at table_index. A reload only overwrites
+// fields that still hold these values
+int ComponentDB::RefDefaults(lua_State* L, int table_index)
+{
+    table_index = lua_absindex(L, table_index);
+    lua_newtable(L);
+
+    lua_pushnil(L);
+    while (lua_next(L, table_index))
+    {
+        if (lua_isfunction(L, -1))
+        {
+            lua_pop(L, 1);
+            continue;
+        }
+        lua_pushvalue(L, -2);
+        lua_insert(L, -2);
+        lua_rawset(L, -4);
+    }
+    return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+// __index of the global table, a missing global named after a component type loads that type
+int ComponentDB::GlobalIndex(lua_State* L)
+{
+    if (lua_type(L, 2) != LUA_TSTRING)
+        return 0;
+
+    std::string name = lua_tostring(L, 2);
+    if (script_paths.count(name) == 0 || loaded_components.count(name) != 0)
+        return 0;
+
+    FindType(name);
+    lua_rawget(L, 1);
+    return 1;
+}
+
+static int AppendBytecode(lua_State*, const void* data, size_t size, void* bytecode)
+{
+    static_cast<std::string*>(bytecode)->append(static_cast<const char*>(data), size);
+    return 0;
+}
+
+// Read the rest of the file from where it is
+static void ReadRest(std::ifstream& file, std::string& out)
+{
+    std::streampos start = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg() - start;
+    file.seekg(start);
+
+    out.resize(static_cast<size_t>(std::max<std::streamoff>(size, 0)));
+    file.read(out.data(), out.size());
+    out.resize(static_cast<size_t>(file.gcount()));
+}
+
+// FNV-1a
+static uint64_t HashSource(const std::string& data)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : data)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Only compiles a script the first time its source is seen, by this run or, through BYTECODE_DIRECTORY, an earlier one.
+// Bytecode from another Lua build fails its header check and is compiled again
+int ComponentDB::LoadScript(lua_State* L, const std::string& component_type)
+{
+    auto path_it = script_paths.find(component_type);
+    if (path_it == script_paths.end())
+    {
+        lua_pushfstring(L, "no script for component type %s", component_type.c_str());
+        return LUA_ERRFILE;
+    }
+
+    const std::string& path = path_it->second;
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        lua_pushfstring(L, "cannot open %s", path.c_str());
+        return LUA_ERRFILE;
+    }
+
+    std::string source;
+    ReadRest(file, source);
+    uint64_t source_hash = HashSource(source);
+    std::string chunk_name = "@" + path;
+
+    auto it = compiled_scripts.find(component_type);
+    if (it != compiled_scripts.end() && it->second.source_hash == source_hash)
+        return luaL_loadbufferx(L, it->second.bytecode.data(), it->second.bytecode.size(), chunk_name.c_str(), "b");
+
+    std::string bytecode;
+    if (ReadCachedBytecode(component_type, source_hash, bytecode))
+    {
+        if (luaL_loadbufferx(L, bytecode.data(), bytecode.size(), chunk_name.c_str(), "b") == LUA_OK)
+        {
+            compiled_scripts[component_type] = { source_hash, std::move(bytecode) };
+            return LUA_OK;
+        }
+        lua_pop(L, 1);
     }
+
+    // Skip a UTF-8 byte order mark like luaL_loadfile does
+    size_t start = source.compare(0, 3, "\xEF\xBB\xBF") == 0 ? 3 : 0;
+    int status = luaL_loadbufferx(L, source.data() + start, source.size() - start, chunk_name.c_str(), "t");
+    if (status != LUA_OK)
+        return status;
+
+    CompiledScript& script = compiled_scripts[component_type];
+    script.source_hash = source_hash;
+    script.bytecode.clear();
+    lua_dump(L, &AppendBytecode, &script.bytecode, 0);
+    WriteCachedBytecode(component_type, script);
+    return LUA_OK;
+}
+
+// A cache file is the source hash and the bytecode's own hash followed by the bytecode. Lua does not check
+// bytecode past its header, so a file cut short by a crash must not get that far
+bool ComponentDB::ReadCachedBytecode(const std::string& component_type, uint64_t source_hash, std::string& bytecode)
+{
+    std::ifstream file(std::string(BYTECODE_DIRECTORY) + "/" + component_type + ".luac", std::ios::binary);
+    uint64_t hashes[2] = {};
+    if (!file || !file.read(reinterpret_cast<char*>(hashes), sizeof(hashes)) || hashes[0] != source_hash)
+        return false;
+
+    ReadRest(file, bytecode);
+    return !bytecode.empty() && HashSource(bytecode) == hashes[1];
+}
+
+// The cache is only an optimization, a read-only install just compiles every run
+void ComponentDB::WriteCachedBytecode(const std::string& component_type, const CompiledScript& script)
+{
+    std::error_code error;
+    std::filesystem::create_directories(BYTECODE_DIRECTORY, error);
+
+    std::ofstream file(std::string(BYTECODE_DIRECTORY) + "/" + component_type + ".luac", std::ios::binary | std::ios::trunc);
+    if (!file)
+        return;
+
+    uint64_t hashes[2] = { script.source_hash, HashSource(script.bytecode) };
+    file.write(reinterpret_cast<const char*>(hashes), sizeof(hashes));
+    file.write(script.bytecode.data(), script.bytecode.size());
 }
 
 std::vector<std::string>& ComponentDB::FindKeys(luabridge::LuaRef ref)
@@ -90,8 +427,8 @@ std::vector<std::string>& ComponentDB::FindKeysCpp(const std::string& component_
 // Create a new component of component_type
 void ComponentDB::GetComponent(luabridge::LuaRef& ref, const std::string& component_type)
 {
-    auto it = loaded_components.find(component_type);
-    if (it == loaded_components.end())
+    luabridge::LuaRef* type_table = FindType(component_type);
+    if (!type_table)
     {
         if (component_type == "Rigidbody") { return CreateCpp<Rigidbody>(ref); }
         if (component_type == "ParticleSystem") { return CreateCpp<ParticleSystem>(ref); }
@@ -100,30 +437,274 @@ void ComponentDB::GetComponent(luabridge::LuaRef& ref, const std::string& compon
         exit(0);
     }
 
-    return EstablishInheritance(ref, *it->second.get());
+    return EstablishInheritance(ref, *type_table);
+}
+
+// Return the id for a type name, interning it on first use
+int ComponentDB::GetTypeID(const std::string& component_type)
+{
+    auto it = type_ids.find(component_type);
+    if (it != type_ids.end())
+        return it->second;
+
+    int type_id = static_cast<int>(type_names.size());
+    type_names.push_back(component_type);
+    type_ids.emplace(component_type, type_id);
+    return type_id;
+}
+
+// Return the id for a type name, -1 if no component of that type was ever created
+int ComponentDB::FindTypeID(const std::string& component_type)
+{
+    auto it = type_ids.find(component_type);
+    return it == type_ids.end() ? -1 : it->second;
+}
+
+// Read a number from the table on top of the stack, fallback when unset
+static float ReadNumber(const char* field, float fallback)
+{
+    float value = fallback;
+    lua_getfield(lua_state, -1, field);
+    if (lua_isnumber(lua_state, -1))
+        value = static_cast<float>(lua_tonumber(lua_state, -1));
+    lua_pop(lua_state, 1);
+    return value;
+}
+
+// Read a frame interval from the table on top of the stack
+static int ReadInterval(const char* field, int fallback, int minimum)
+{
+    return std::clamp(static_cast<int>(ReadNumber(field, static_cast<float>(fallback))), minimum, 600);
+}
+
+// Resolve a type's lifecycle functions on first use and pin them in the registry
+const ComponentHooks* ComponentDB::GetHooks(const std::string& component_type, luabridge::LuaRef& instance)
+{
+    auto it = hook_cache.find(component_type);
+    if (it != hook_cache.end())
+        return &it->second;
+
+    ComponentHooks& hooks = hook_cache[component_type];
+    std::fill(std::begin(hooks.functions), std::end(hooks.functions), LUA_NOREF);
+    instance.push(lua_state);
+
+    lua_getfield(lua_state, -1, "parallel");
+    hooks.parallel = lua_toboolean(lua_state, -1) && ScriptShards::IsEnabled();
+    lua_pop(lua_state, 1);
+    if (hooks.parallel)
+        ScriptShards::Start();
+
+    ReadHooks(component_type, hooks, false);
+    lua_pop(lua_state, 1);
+    return &hooks;
+}
+
+// Pin the lifecycle functions of the table on top of the stack in place of the ones pinned before, and read
+// its update settings. A type stays parallel or not until restart, shard instances cannot move states
+void ComponentDB::ReadHooks(const std::string& component_type, ComponentHooks& hooks, bool reloading)
+{
+    for (int hook = 0; hook < HOOK_COUNT; hook++)
+    {
+        luaL_unref(lua_state, LUA_REGISTRYINDEX, hooks.functions[hook]);
+        lua_getfield(lua_state, -1, HOOK_NAMES[hook]);
+        if (lua_isfunction(lua_state, -1))
+        {
+            hooks.functions[hook] = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+        }
+        else
+        {
+            hooks.functions[hook] = LUA_NOREF;
+            lua_pop(lua_state, 1);
+        }
+    }
+
+    hooks.update_interval = ReadInterval("update_interval", 1, 1);
+    hooks.late_update_interval = ReadInterval("late_update_interval", 1, 1);
+    hooks.lod_distance = ReadNumber("lod_distance", 0.0f);
+    hooks.far_update_interval = ReadInterval("far_update_interval", 0, 0);
+
+    // Collisions are handed over as main state objects in the middle of the physics step
+    if (!hooks.parallel)
+        return;
+
+    for (int hook = HOOK_COLLISION_ENTER; hook <= HOOK_TRIGGER_EXIT; hook++)
+    {
+        if (hooks.functions[hook] == LUA_NOREF)
+            continue;
+
+        std::string message = "parallel component " + component_type + " cannot implement " + HOOK_NAMES[hook];
+        if (!reloading)
+        {
+            std::cout << "error: " << message;
+            exit(0);
+        }
+
+        // A reload keeps running without it
+        EngineUtils::ReportError(component_type, message);
+        luaL_unref(lua_state, LUA_REGISTRYINDEX, hooks.functions[hook]);
+        hooks.functions[hook] = LUA_NOREF;
+    }
 }
 
 // Establish Inheratiance
 void ComponentDB::EstablishInheritance(luabridge::LuaRef& instance_table, luabridge::LuaRef& parent_table)
 {
-    // We must create a metatable to establish inheritance in lua.
-    luabridge::LuaRef new_metatable = luabridge::newTable(lua_state);
-    new_metatable["__index"] = parent_table;
+    // Instances start with the enabled state of their parent, type tables count as enabled
+    bool enabled = true;
+    if (bool* parent_enabled = GetEnabledFlag(parent_table, ""))
+        enabled = *parent_enabled;
 
     // We must use the raw lua C-API (lua stack) to perform a "setmetatable" operation.
+    // Every instance of the same parent and enabled state shares one metatable
+    InitInheritanceCache();
     instance_table.push(lua_state);
-    new_metatable.push(lua_state);
+    NewEnabledCell(-1, enabled);
+    PushParentMetatable(parent_table, enabled);
     lua_setmetatable(lua_state, -2);
     lua_pop(lua_state, 1);
 }
 
+// Pin the shared metatable for instances of parent_table in the registry, for spawn plans
+int ComponentDB::RefParentMetatable(luabridge::LuaRef& parent_table, bool enabled)
+{
+    InitInheritanceCache();
+    PushParentMetatable(parent_table, enabled);
+    return luaL_ref(lua_state, LUA_REGISTRYINDEX);
+}
+
+// Give the instance table at the stack index its enabled cell. The C++ side of enabled
+// lives in a userdata keyed weakly by the instance
+bool* ComponentDB::NewEnabledCell(int instance_index, bool enabled)
+{
+    instance_index = lua_absindex(lua_state, instance_index);
+
+    enabled_cells->push(lua_state);
+    lua_pushvalue(lua_state, instance_index);
+    bool* cell = static_cast<bool*>(lua_newuserdatauv(lua_state, sizeof(bool), 0));
+    *cell = enabled;
+    lua_rawset(lua_state, -3);
+    lua_pop(lua_state, 1);
+
+    return cell;
+}
+
+// Return the C++ side of a component's enabled field, nullptr if it has none
+bool* ComponentDB::GetEnabledFlag(luabridge::LuaRef& instance, const std::string& component_type)
+{
+    if (component_type == "Rigidbody")
+        return &instance.cast<Rigidbody*>()->enabled;
+    if (component_type == "ParticleSystem")
+        return &instance.cast<ParticleSystem*>()->enabled;
+
+    if (!enabled_cells)
+        return nullptr;
+
+    enabled_cells->push(lua_state);
+    instance.push(lua_state);
+    lua_rawget(lua_state, -2);
+    bool* flag = static_cast<bool*>(lua_touserdata(lua_state, -1));
+    lua_pop(lua_state, 2);
+    return flag;
+}
+
+// Create the weak tables that hold per-parent metatables and per-instance enabled cells
+void ComponentDB::InitInheritanceCache()
+{
+    if (parent_metatables)
+        return;
+
+    luabridge::LuaRef weak_keys = luabridge::newTable(lua_state);
+    weak_keys["__mode"] = std::string("k");
+
+    parent_metatables = std::make_unique<luabridge::LuaRef>(luabridge::newTable(lua_state));
+    enabled_cells = std::make_unique<luabridge::LuaRef>(luabridge::newTable(lua_state));
+    for (luabridge::LuaRef* table : { parent_metatables.get(), enabled_cells.get() })
+    {
+        table->push(lua_state);
+        weak_keys.push(lua_state);
+        lua_setmetatable(lua_state, -2);
+        lua_pop(lua_state, 1);
+    }
+}
+
+// Push the shared metatable for instances of parent_table in the given enabled state.
+// Each parent gets two, whose __index is a proxy holding enabled = true or false and inheriting from the parent
+void ComponentDB::PushParentMetatable(luabridge::LuaRef& parent_table, bool enabled)
+{
+    parent_metatables->push(lua_state);
+    parent_table.push(lua_state);
+    if (lua_rawget(lua_state, -2) != LUA_TTABLE)
+    {
+        lua_pop(lua_state, 1);
+
+        luabridge::LuaRef proxy_metatable = luabridge::newTable(lua_state);
+        proxy_metatable["__index"] = parent_table;
+
+        // { [1] = enabled metatable, [2] = disabled metatable }, each metatable points back at the pair
+        lua_createtable(lua_state, 2, 0);
+        for (int i = 1; i <= 2; i++)
+        {
+            lua_createtable(lua_state, 0, 3);
+
+            lua_createtable(lua_state, 0, 1);
+            lua_pushboolean(lua_state, i == 1);
+            lua_setfield(lua_state, -2, "enabled");
+            proxy_metatable.push(lua_state);
+            lua_setmetatable(lua_state, -2);
+            lua_setfield(lua_state, -2, "__index");
+
+            enabled_cells->push(lua_state);
+            lua_pushcclosure(lua_state, &InstanceNewIndex, 1);
+            lua_setfield(lua_state, -2, "__newindex");
+
+            lua_pushvalue(lua_state, -2);
+            lua_setfield(lua_state, -2, "__states");
+
+            lua_rawseti(lua_state, -2, i);
+        }
+
+        parent_table.push(lua_state);
+        lua_pushvalue(lua_state, -2);
+        lua_rawset(lua_state, -4);
+    }
+
+    lua_rawgeti(lua_state, -1, enabled ? 1 : 2);
+    lua_replace(lua_state, -3);
+    lua_pop(lua_state, 1);
+}
+
+// Writes of new keys to an instance. enabled updates the C++ cell and swaps to the matching shared metatable,
+// everything else is stored in the instance
+int ComponentDB::InstanceNewIndex(lua_State* L)
+{
+    const char* key = lua_type(L, 2) == LUA_TSTRING ? lua_tostring(L, 2) : nullptr;
+    if (key == nullptr || std::strcmp(key, "enabled") != 0)
+    {
+        lua_rawset(L, 1);
+        return 0;
+    }
+
+    bool enabled = lua_toboolean(L, 3);
+    lua_pushvalue(L, 1);
+    lua_rawget(L, lua_upvalueindex(1));
+    if (bool* cell = static_cast<bool*>(lua_touserdata(L, -1)))
+        *cell = enabled;
+
+    lua_getmetatable(L, 1);
+    lua_getfield(L, -1, "__states");
+    lua_rawgeti(L, -1, enabled ? 1 : 2);
+    lua_setmetatable(L, 1);
+    lua_pop(L, 3);
+    return 0;
+}
+
 std::vector<std::string> ComponentDB::ListAllComponentTypes()
 {
     static std::vector<std::string> list;
     list.clear();
-    list.reserve(loaded_components.size());
+    list.reserve(script_paths.size() + 2);
 
-    for (auto& pair : loaded_components)
+    for (auto& pair : script_paths)
     {
         list.push_back(pair.first);
     }
@@ -4,15 +4,66 @@
 #include "lua/lua.hpp"
 #include "LuaBridge/LuaBridge.h"
 
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <string>
 
 extern inline lua_State* lua_state = nullptr;
 
+// Lifecycle functions a component may implement
+enum ComponentHook
+{
+	HOOK_START,
+	HOOK_UPDATE,
+	HOOK_LATE_UPDATE,
+	HOOK_FIXED_UPDATE,
+	HOOK_COLLISION_ENTER,
+	HOOK_COLLISION_EXIT,
+	HOOK_TRIGGER_ENTER,
+	HOOK_TRIGGER_EXIT,
+	HOOK_DESTROY,
+	HOOK_RELEASE,
+	HOOK_REUSE,
+	HOOK_COUNT
+};
+
+inline const char* const HOOK_NAMES[HOOK_COUNT] = {
+	"OnStart", "OnUpdate", "OnLateUpdate", "OnFixedUpdate",
+	"OnCollisionEnter", "OnCollisionExit", "OnTriggerEnter", "OnTriggerExit",
+	"OnDestroy", "OnRelease", "OnReuse"
+};
+
+// Registry references to a component type's lifecycle functions, LUA_NOREF if not implemented,
+// and how many frames apart the type's OnUpdate and OnLateUpdate run. Past lod_distance from the
+// update focus both run every far_update_interval frames, 0 suspends them. Parallel types run in the script shards
+struct ComponentHooks
+{
+	int functions[HOOK_COUNT];
+	int update_interval = 1;
+	int late_update_interval = 1;
+	float lod_distance = 0.0f;
+	int far_update_interval = 0;
+	bool parallel = false;
+};
+
 class ComponentDB
 {
 public:
 	static void Init();
 	static std::vector<std::string>& GetKeys(const std::string& component_type);
+
+	// Push a component type's compiled script onto L, from the bytecode cache when its source is unchanged.
+	// Returns the lua_load status, with the error message pushed instead on failure
+	static int LoadScript(lua_State* L, const std::string& component_type);
+
+	// Hot reload. AddScript makes a script saved after Init known, Reload merges a changed script into its
+	// loaded type, and MergeScript does the merge in any state, L's defaults_ref being the type's RefDefaults
+	static void AddScript(const std::string& component_type, const std::string& path) { script_paths[component_type] = path; }
+	static bool Reload(const std::string& component_type);
+	static bool MergeScript(lua_State* L, const std::string& component_type, int& defaults_ref);
+	static int RefDefaults(lua_State* L, int table_index);
+
 	static void GetComponent(luabridge::LuaRef& ref, const std::string& component_type);
 	
 	template <typename T>
@@ -30,12 +81,62 @@ public:
 	}
 
 	static void EstablishInheritance(luabridge::LuaRef& instance_table, luabridge::LuaRef& parent_table);
+	static bool* GetEnabledFlag(luabridge::LuaRef& instance, const std::string& component_type);
+
+	static int RefParentMetatable(luabridge::LuaRef& parent_table, bool enabled);
+	static bool* NewEnabledCell(int instance_index, bool enabled);
 	static std::vector<std::string> ListAllComponentTypes();
 
-	static void ResetDatabase() { loaded_components.clear(); }
+	static const ComponentHooks* GetHooks(const std::string& component_type, luabridge::LuaRef& instance);
+
+	// Interned type names, ids stay valid for the whole run
+	static int GetTypeID(const std::string& component_type);
+	static int FindTypeID(const std::string& component_type);
+	static const std::string& GetTypeName(int type_id) { return type_names[type_id]; }
+
+	static void ResetDatabase();
+
+	static constexpr const char* COMPONENT_DIRECTORY = "resources/component_types";
 
 private:
 	static inline std::unordered_map<std::string, std::unique_ptr<luabridge::LuaRef>> loaded_components;
+
+	// Script of every component type, found by Init without running any. Types load on first use
+	static inline std::unordered_map<std::string, std::string> script_paths;
+
+	// Registry refs to each loaded type's fields as its script last set them, see RefDefaults
+	static inline std::unordered_map<std::string, int> default_refs;
+
+	// Bytecode of each script compiled this run and the hash of the source it came from. Kept across
+	// ResetDatabase, and mirrored to BYTECODE_DIRECTORY for the next run
+	struct CompiledScript
+	{
+		uint64_t source_hash;
+		std::string bytecode;
+	};
+	static inline std::unordered_map<std::string, CompiledScript> compiled_scripts;
+
+	static constexpr const char* PRELOAD_MANIFEST = "resources/preload.config";
+	static constexpr const char* BYTECODE_DIRECTORY = ".lua_cache";
+	static inline std::unordered_map<std::string, ComponentHooks> hook_cache;
+
+	static inline std::unordered_map<std::string, int> type_ids;
+	static inline std::deque<std::string> type_names;
+
+	// Weak parent table -> { [1] = enabled metatable, [2] = disabled metatable }
+	static inline std::unique_ptr<luabridge::LuaRef> parent_metatables;
+	// Weak instance table -> bool userdata mirrored by Component::enabled
+	static inline std::unique_ptr<luabridge::LuaRef> enabled_cells;
+
+	static luabridge::LuaRef* FindType(const std::string& component_type);
+	static int GlobalIndex(lua_State* L);
+	static void ReadHooks(const std::string& component_type, ComponentHooks& hooks, bool reloading);
+	static bool ReadCachedBytecode(const std::string& component_type, uint64_t source_hash, std::string& bytecode);
+	static void WriteCachedBytecode(const std::string& component_type, const CompiledScript& script);
+
+	static void InitInheritanceCache();
+	static void PushParentMetatable(luabridge::LuaRef& parent_table, bool enabled);
+	static int InstanceNewIndex(lua_State* L);
 	static std::vector<std::string>& FindKeys(luabridge::LuaRef ref);
 	static std::vector<std::string>& FindKeysCpp(const std::string& component_type);
 };
@@ -0,0 +1,89 @@
+#include "ComponentIndex.h"
+
+#include "Actor.h"
+
+// Append component to its type's bucket, remembering its slot for removal
+void ComponentIndex::Add(Actor* actor, Component* component)
+{
+    if (component->index_slot != -1 || component->type_id < 0)
+        return;
+
+    if (component->type_id >= static_cast<int>(buckets.size()))
+        buckets.resize(component->type_id + 1);
+
+    std::vector<Entry>& entries = buckets[component->type_id].entries;
+    component->index_slot = static_cast<int>(entries.size());
+    entries.push_back({ actor, component });
+}
+
+// Leave a hole in the component's slot
+void ComponentIndex::Remove(Component* component)
+{
+    int slot = component->index_slot;
+    if (slot == -1)
+        return;
+
+    Bucket& bucket = buckets[component->type_id];
+    bucket.entries[slot].component = nullptr;
+    bucket.has_holes = true;
+    has_holes = true;
+
+    component->index_slot = -1;
+}
+
+// Point the component's slot at its new address after its owner's storage moved
+void ComponentIndex::Relocate(Component* component)
+{
+    int slot = component->index_slot;
+    if (slot != -1)
+        buckets[component->type_id].entries[slot].component = component;
+}
+
+void ComponentIndex::Clear()
+{
+    for (Bucket& bucket : buckets)
+        for (Entry& e : bucket.entries)
+            if (e.component)
+                e.component->index_slot = -1;
+
+    buckets.clear();
+    has_holes = false;
+}
+
+// Close holes without reordering the remaining entries
+void ComponentIndex::Compact()
+{
+    if (!has_holes)
+        return;
+
+    for (Bucket& bucket : buckets)
+    {
+        if (!bucket.has_holes)
+            continue;
+
+        std::vector<Entry>& entries = bucket.entries;
+        size_t j = 0;
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (!entries[i].component)
+                continue;
+
+            entries[j] = entries[i];
+            entries[j].component->index_slot = static_cast<int>(j);
+            j++;
+        }
+
+        entries.resize(j);
+        bucket.has_holes = false;
+    }
+    has_holes = false;
+}
+
+const std::vector<ComponentIndex::Entry>& ComponentIndex::Get(int type_id) const
+{
+    static const std::vector<Entry> empty;
+    if (type_id < 0 || type_id >= static_cast<int>(buckets.size()))
+        return empty;
+
+    return buckets[type_id].entries;
+}
@@ -0,0 +1,42 @@
+#ifndef COMPONENT_INDEX_H
+#define COMPONENT_INDEX_H
+
+#include "ComponentManager.h"
+
+#include <vector>
+
+class Actor;
+
+// Live scene components grouped by interned type id, kept up to date alongside the hook lists.
+// Removal leaves a hole that is compacted at the end of the frame, so queries never see entries shift.
+class ComponentIndex
+{
+public:
+    struct Entry
+    {
+        Actor* actor = nullptr;
+        Component* component = nullptr;
+    };
+
+    void Add(Actor* actor, Component* component);
+    void Remove(Component* component);
+    void Relocate(Component* component);
+    void Clear();
+
+    void Compact();
+
+    // Entries of one type, holes have a null component
+    const std::vector<Entry>& Get(int type_id) const;
+
+private:
+    struct Bucket
+    {
+        std::vector<Entry> entries;
+        bool has_holes = false;
+    };
+
+    std::vector<Bucket> buckets;
+    bool has_holes = false;
+};
+
+#endif
@@ -1,14 +1,24 @@
 #include "ComponentManager.h"
 
 #include "Actor.h"
+#include "ActorPool.h"
 #include "AudioDB.h"
+#include "CoroutineScheduler.h"
+#include "EngineUtils.h"
 #include "EventBus.h"
 #include "Input.h"
 #include "ParticleSystem.h"
+#include "Profiler.h"
 #include "Renderer.h"
 #include "Rigidbody.h"
 #include "SceneDB.h"
+#include "ScriptGC.h"
+#include "ScriptMemory.h"
+#include "ScriptProfiler.h"
+#include "ScriptShards.h"
+#include "TagDB.h"
 #include "TextDB.h"
+#include "Timestep.h"
 
 #include "KeycodeToScancode.h"
 
@@ -26,8 +36,9 @@ void ComponentManager::Init()
 // Initalize lua_state
 void ComponentManager::InitState()
 {
-    lua_state = luaL_newstate();
+    lua_state = ScriptMemory::NewState();
     luaL_openlibs(lua_state);
+    ScriptGC::AddState(lua_state, true);
 }
 
 // Inject the scripting API
@@ -37,18 +48,35 @@ void ComponentManager::InitFunctions()
     luabridge::getGlobalNamespace(lua_state)
         .beginNamespace("Debug")
         .addFunction("Log", &Print)
+        .addFunction("DumpTrace", &Profiler::DumpTrace)
+        .addFunction("GetProfile", &ScriptProfiler::GetProfile)
+        .addFunction("ResetProfile", &ScriptProfiler::Reset)
+        .addFunction("GetGCStats", &ScriptGC::GetStats)
+        .addFunction("GetLuaMemory", &ScriptMemory::GetStats)
         .endNamespace();
 
-    // Actor instances
+    // Actor instances, scripts hold generational handles rather than pointers
     luabridge::getGlobalNamespace(lua_state)
-        .beginClass<Actor>("Actor")
-        .addFunction("GetName", &Actor::GetName)
-        .addFunction("GetID", &Actor::GetID)
-        .addFunction("GetComponentByKey", &Actor::GetComponentByKey)
-        .addFunction("GetComponent", &Actor::GetComponent)
-        .addFunction("GetComponents", &Actor::GetComponents)
-        .addFunction("AddComponent", &Actor::AddComponent)
-        .addFunction("RemoveComponent", &Actor::RemoveComponent)
+        .beginClass<ActorHandle>("Actor")
+        .addFunction("IsValid", &ActorIsValid)
+        .addFunction("__eq", &ActorEquals)
+        .addFunction("GetName", &ActorGetName)
+        .addFunction("GetID", &ActorGetID)
+        .addFunction("GetComponentByKey", &ActorGetComponentByKey)
+        .addFunction("GetComponent", &ActorGetComponent)
+        .addFunction("GetComponents", &ActorGetComponents)
+        .addFunction("AddComponent", &ActorAddComponent)
+        .addFunction("RemoveComponent", &ActorRemoveComponent)
+        .addFunction("GetTags", &ActorGetTags)
+        .addFunction("HasTags", &ActorHasTags)
+        .addFunction("SetTags", &ActorSetTags)
+        .addFunction("AddTags", &ActorAddTags)
+        .addFunction("RemoveTags", &ActorRemoveTags)
+        .addFunction("GetLayer", &ActorGetLayer)
+        .addFunction("SetLayer", &ActorSetLayer)
+        .addFunction("SetPosition", &ActorSetPosition)
+        .addFunction("GetPosition", &ActorGetPosition)
+        .addFunction("ClearPosition", &ActorClearPosition)
         .endClass();
 
     // Actor functions
@@ -56,8 +84,14 @@ void ComponentManager::InitFunctions()
         .beginNamespace("Actor")
         .addFunction("Find", &SceneDB::Find)
         .addFunction("FindAll", &SceneDB::FindAll)
+        .addFunction("FindWithTags", &SceneDB::FindWithTags)
+        .addFunction("FindInLayer", &SceneDB::FindInLayer)
+        .addFunction("GetTagMask", static_cast<uint32_t (*)(const std::string&)>(&TagDB::GetTagMask))
+        .addFunction("GetLayerMask", &TagDB::GetLayerMask)
         .addFunction("Instantiate", &SceneDB::Instantiate)
+        .addFunction("InstantiateMany", &SceneDB::InstantiateMany)
         .addFunction("Destroy", &SceneDB::Destroy)
+        .addFunction("Release", &SceneDB::Release)
         .endNamespace();
 
     // Application functions
@@ -66,6 +100,8 @@ void ComponentManager::InitFunctions()
         .addFunction("Quit", &Quit)
         .addFunction("Sleep", &Sleep)
         .addFunction("GetFrame", &GetFrame)
+        .addFunction("GetDeltaTime", &Timestep::GetDeltaTime)
+        .addFunction("GetFixedDeltaTime", &Timestep::GetFixedDeltaTime)
         .addFunction("OpenURL", &OpenURL)
         .endNamespace();
 
@@ -121,6 +157,8 @@ void ComponentManager::InitFunctions()
         .addFunction("SetPosition", &Renderer::MoveCamera)
         .addFunction("GetPositionX", &Renderer::GetCameraX)
         .addFunction("GetPositionY", &Renderer::GetCameraY)
+        .addFunction("SetCullingMask", &Renderer::SetCullingMask)
+        .addFunction("GetCullingMask", &Renderer::GetCullingMask)
         .addFunction("SetZoom", &Renderer::SetZoom)
         .addFunction("GetZoom", &Renderer::GetZoom)
         .endNamespace();
@@ -131,29 +169,22 @@ void ComponentManager::InitFunctions()
         .addFunction("Load", &SceneDB::QueueLoad)
         .addFunction("GetCurrent", &SceneDB::GetCurrent)
         .addFunction("DontDestroy", &SceneDB::DontDestroy)
+        .addFunction("Query", &SceneDB::Query)
+        .addFunction("ForEach", &SceneDB::ForEach)
+        .addFunction("FindInRadius", &SceneDB::FindInRadius)
+        .addFunction("FindInRect", &SceneDB::FindInRect)
+        .addFunction("SetUpdateFocus", &SceneDB::SetUpdateFocus)
         .endNamespace();
 
-    // Vector2 data type
-    luabridge::getGlobalNamespace(lua_state)
-        .beginClass<b2Vec2>("Vector2")
-        .addConstructor <void (*) (void)>()
-        .addConstructor <void (*) (float, float)>()
-        .addProperty("x", &b2Vec2::x)
-        .addProperty("y", &b2Vec2::y)
-        .addFunction("Normalize", &b2Vec2::Normalize)
-        .addFunction("Length", &b2Vec2::Length)
-        .addFunction("__add", &b2Vec2::operator_add)
-        .addFunction("__sub", &b2Vec2::operator_sub)
-        .addFunction("__mul", &b2Vec2::operator_mul)
-        .addStaticFunction("Distance", &b2Distance)
-        .addStaticFunction("Dot", static_cast<float (*)(const b2Vec2&, const b2Vec2&)>(&b2Dot))
-        .endClass();
-    
+    InitVector2(lua_state);
+
     // Rigidbody class
     luabridge::getGlobalNamespace(lua_state)
         .beginClass<Rigidbody>("Rigidbody")
         .addFunction("OnStart", &Rigidbody::OnStart)
         .addFunction("OnDestroy", &Rigidbody::OnDestroy)
+        .addFunction("OnRelease", &Rigidbody::OnRelease)
+        .addFunction("OnReuse", &Rigidbody::OnReuse)
         .addData("type", &Rigidbody::type)
         .addData("key", &Rigidbody::key)
         .addData("actor", &Rigidbody::actor)
@@ -180,6 +211,8 @@ void ComponentManager::InitFunctions()
         .addData("trigger_radius", &Rigidbody::trigger_radius)
         .addFunction("GetPosition", &Rigidbody::GetPosition)
         .addFunction("GetRotation", &Rigidbody::GetRotation)
+        .addFunction("GetInterpolatedPosition", &Rigidbody::GetInterpolatedPosition)
+        .addFunction("GetInterpolatedRotation", &Rigidbody::GetInterpolatedRotation)
         .addFunction("AddForce", &Rigidbody::AddForce)
         .addFunction("SetVelocity", &Rigidbody::SetVelocity)
         .addFunction("SetPosition", &Rigidbody::SetPosition)
@@ -228,6 +261,20 @@ void ComponentManager::InitFunctions()
         .addFunction("Unsubscribe", &EventBus::Unsubscribe)
         .endNamespace();
 
+    // Coroutine functions, the Wait functions yield the running coroutine
+    luabridge::getGlobalNamespace(lua_state)
+        .beginNamespace("Coroutine")
+        .addCFunction("Start", &CoroutineScheduler::Start)
+        .addCFunction("Stop", &CoroutineScheduler::Stop)
+        .endNamespace();
+
+    luabridge::getGlobalNamespace(lua_state)
+        .beginNamespace("Wait")
+        .addCFunction("Frames", &CoroutineScheduler::WaitFrames)
+        .addCFunction("Seconds", &CoroutineScheduler::WaitSeconds)
+        .addCFunction("Event", &CoroutineScheduler::WaitEvent)
+        .endNamespace();
+
     // ParticleSystem class
     luabridge::getGlobalNamespace(lua_state)
         .beginClass<ParticleSystem>("ParticleSystem")
@@ -275,6 +322,25 @@ void ComponentManager::InitFunctions()
         .endClass();
 }
 
+// Vector2 data type
+void ComponentManager::InitVector2(lua_State* L)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<b2Vec2>("Vector2")
+        .addConstructor <void (*) (void)>()
+        .addConstructor <void (*) (float, float)>()
+        .addProperty("x", &b2Vec2::x)
+        .addProperty("y", &b2Vec2::y)
+        .addFunction("Normalize", &b2Vec2::Normalize)
+        .addFunction("Length", &b2Vec2::Length)
+        .addFunction("__add", &b2Vec2::operator_add)
+        .addFunction("__sub", &b2Vec2::operator_sub)
+        .addFunction("__mul", &b2Vec2::operator_mul)
+        .addStaticFunction("Distance", &b2Distance)
+        .addStaticFunction("Dot", static_cast<float (*)(const b2Vec2&, const b2Vec2&)>(&b2Dot))
+        .endClass();
+}
+
 // Open URL
 void ComponentManager::OpenURL(const std::string& url)
 {
@@ -289,6 +355,138 @@ void ComponentManager::OpenURL(const std::string& url)
     std::system(cmd.c_str());
 }
 
+// Return true while the handle refers to a live actor
+bool ComponentManager::ActorIsValid(const ActorHandle* handle)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    return actor && actor->IsAlive();
+}
+
+bool ComponentManager::ActorEquals(const ActorHandle* handle, const ActorHandle& other)
+{
+    return *handle == other;
+}
+
+luabridge::LuaRef ComponentManager::ActorGetName(const ActorHandle* handle)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(lua_state);
+    return luabridge::LuaRef(lua_state, actor->GetName());
+}
+
+luabridge::LuaRef ComponentManager::ActorGetID(const ActorHandle* handle)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(lua_state);
+    return luabridge::LuaRef(lua_state, actor->GetID());
+}
+
+luabridge::LuaRef ComponentManager::ActorGetComponentByKey(const ActorHandle* handle, const std::string& key)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(lua_state);
+    return actor->GetComponentByKey(key);
+}
+
+luabridge::LuaRef ComponentManager::ActorGetComponent(const ActorHandle* handle, const std::string& type_name)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(lua_state);
+    return actor->GetComponent(type_name);
+}
+
+luabridge::LuaRef ComponentManager::ActorGetComponents(const ActorHandle* handle, const std::string& type_name)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(lua_state);
+    return actor->GetComponents(type_name);
+}
+
+luabridge::LuaRef ComponentManager::ActorAddComponent(const ActorHandle* handle, const std::string& type_name)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(lua_state);
+    return actor->AddComponent(type_name);
+}
+
+void ComponentManager::ActorRemoveComponent(const ActorHandle* handle, luabridge::LuaRef component_ref)
+{
+    if (Actor* actor = ActorPool::Resolve(*handle))
+        actor->RemoveComponent(component_ref);
+}
+
+luabridge::LuaRef ComponentManager::ActorGetTags(const ActorHandle* handle)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(lua_state);
+    return luabridge::LuaRef(lua_state, actor->GetTags());
+}
+
+bool ComponentManager::ActorHasTags(const ActorHandle* handle, uint32_t mask)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    return actor && (actor->GetTags() & mask) == mask;
+}
+
+void ComponentManager::ActorSetTags(const ActorHandle* handle, uint32_t mask)
+{
+    if (Actor* actor = ActorPool::Resolve(*handle))
+        SceneDB::SetTags(actor, mask);
+}
+
+void ComponentManager::ActorAddTags(const ActorHandle* handle, uint32_t mask)
+{
+    if (Actor* actor = ActorPool::Resolve(*handle))
+        SceneDB::SetTags(actor, actor->GetTags() | mask);
+}
+
+void ComponentManager::ActorRemoveTags(const ActorHandle* handle, uint32_t mask)
+{
+    if (Actor* actor = ActorPool::Resolve(*handle))
+        SceneDB::SetTags(actor, actor->GetTags() & ~mask);
+}
+
+luabridge::LuaRef ComponentManager::ActorGetLayer(const ActorHandle* handle)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(lua_state);
+    return luabridge::LuaRef(lua_state, TagDB::GetLayerName(actor->GetLayer()));
+}
+
+void ComponentManager::ActorSetLayer(const ActorHandle* handle, const std::string& layer_name)
+{
+    if (Actor* actor = ActorPool::Resolve(*handle))
+        SceneDB::SetLayer(actor, TagDB::GetLayer(layer_name));
+}
+
+void ComponentManager::ActorSetPosition(const ActorHandle* handle, float x, float y)
+{
+    if (Actor* actor = ActorPool::Resolve(*handle))
+        SceneDB::SetPosition(actor, x, y);
+}
+
+luabridge::LuaRef ComponentManager::ActorGetPosition(const ActorHandle* handle)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(lua_state);
+    return SceneDB::GetPosition(actor);
+}
+
+void ComponentManager::ActorClearPosition(const ActorHandle* handle)
+{
+    if (Actor* actor = ActorPool::Resolve(*handle))
+        SceneDB::ClearPosition(actor);
+}
+
 // Get if key is pressed
 bool ComponentManager::GetKey(const std::string& keycode)
 {
@@ -319,62 +517,109 @@ bool ComponentManager::GetKeyUp(const std::string& keycode)
 // Component constructor
 Component::Component()
 {
+    ScriptMemory::Scope memory_scope(MEMORY_COMPONENTS);
     component_ref = std::make_shared<luabridge::LuaRef>(luabridge::newTable(lua_state));
-    (*component_ref)["enabled"] = true;
-    
-    has_start = false;
-    has_update = false;
-    has_late_update = false;
 
-    has_collision_enter = false;
-    has_collision_exit = false;
-    has_trigger_enter = false;
-    has_trigger_exit = false;
+    type_id = -1;
+    hooks = nullptr;
+    enabled = nullptr;
+    started = false;
+    alive = true;
 
-    has_destroy = false;
+    std::fill(std::begin(dispatch_slots), std::end(dispatch_slots), -1);
+    std::fill(std::begin(dispatch_buckets), std::end(dispatch_buckets), 0);
+    index_slot = -1;
+    lod_slot = -1;
+    lod_far = false;
+}
 
+// Adopt an instance table that was already built, used by spawn plans
+Component::Component(luabridge::LuaRef instance)
+{
+    component_ref = std::make_shared<luabridge::LuaRef>(std::move(instance));
+
+    type_id = -1;
+    hooks = nullptr;
+    enabled = nullptr;
+    started = false;
     alive = true;
+
+    std::fill(std::begin(dispatch_slots), std::end(dispatch_slots), -1);
+    std::fill(std::begin(dispatch_buckets), std::end(dispatch_buckets), 0);
+    index_slot = -1;
+    lod_slot = -1;
+    lod_far = false;
 }
 
 Component& Component::operator=(const Component& parent_component)
 {
+    ScriptMemory::Scope memory_scope(MEMORY_COMPONENTS);
     luabridge::LuaRef& ref = *component_ref;
-    type = parent_component.type;
+    type_id = parent_component.type_id;
+    hooks = parent_component.hooks;
+
+    const std::string& type = GetType();
     if (type == "Rigidbody")
     {
         ComponentDB::CreateCpp<Rigidbody>(ref, *parent_component.component_ref);
-        has_start = true;
-        has_destroy = true;
     }
     else if (type == "ParticleSystem")
     {
         ComponentDB::CreateCpp<ParticleSystem>(ref, *parent_component.component_ref);
-        has_start = true;
-        has_update = true;
     }
     else
     {
         // Establish inheritance to base component
         ComponentDB::EstablishInheritance(ref, *parent_component.component_ref);
+    }
+    enabled = ComponentDB::GetEnabledFlag(ref, type);
+    return *this;
+}
 
-        has_start = parent_component.has_start;
-        has_update = parent_component.has_update;
-        has_late_update = parent_component.has_late_update;
+// Report the error on top of the stack and pop it
+static void ReportCallError(const std::string& actor_name)
+{
+    const char* message = lua_tostring(lua_state, -1);
+    EngineUtils::ReportError(actor_name, message ? message : "error object is not a string");
+    lua_pop(lua_state, 1);
+}
 
-        has_collision_enter = parent_component.has_collision_enter;
-        has_collision_exit = parent_component.has_collision_exit;
-        has_trigger_enter = parent_component.has_trigger_enter;
-        has_trigger_exit = parent_component.has_trigger_exit;
+// Call a cached lifecycle function with self
+void Component::Call(ComponentHook hook, const std::string& actor_name)
+{
+    if (IsParallel())
+        return ScriptShards::Call(*this, hook, actor_name);
+
+    ScriptMemory::TypeScope memory_scope(type_id);
+    lua_rawgeti(lua_state, LUA_REGISTRYINDEX, hooks->functions[hook]);
+    component_ref->push(lua_state);
+    if (lua_pcall(lua_state, 1, 0, 0) != LUA_OK)
+        ReportCallError(actor_name);
+}
 
-        has_destroy = parent_component.has_destroy;
-    }
-    return *this;
+// Call a cached lifecycle function with self and the frames since its last call, used by the scene hook lists
+void Component::Call(ComponentHook hook, const std::string& actor_name, int frames)
+{
+    if (IsParallel())
+        return ScriptShards::Call(*this, hook, actor_name, frames);
+
+    ScriptMemory::TypeScope memory_scope(type_id);
+    lua_rawgeti(lua_state, LUA_REGISTRYINDEX, hooks->functions[hook]);
+    component_ref->push(lua_state);
+    lua_pushinteger(lua_state, frames);
+    if (lua_pcall(lua_state, 2, 0, 0) != LUA_OK)
+        ReportCallError(actor_name);
 }
 
-// Return true if component is enabled
-bool Component::IsEnabled() const
+// Call a cached collision function with self and a copy of the collision
+void Component::Call(ComponentHook hook, const std::string& actor_name, Collision& collision)
 {
-    return (*component_ref)["enabled"];
+    ScriptMemory::TypeScope memory_scope(type_id);
+    lua_rawgeti(lua_state, LUA_REGISTRYINDEX, hooks->functions[hook]);
+    component_ref->push(lua_state);
+    luabridge::Stack<Collision>::push(lua_state, collision);
+    if (lua_pcall(lua_state, 2, 0, 0) != LUA_OK)
+        ReportCallError(actor_name);
 }
 
 
@@ -1,6 +1,7 @@
 #ifndef COMPONENT_MANAGER_H
 #define COMPONENT_MANAGER_H
 
+#include "ActorHandle.h"
 #include "ComponentDB.h"
 
 #include "Helper.h"
@@ -19,38 +20,89 @@ public:
     static int GetFrame() { return Helper::GetFrameNumber(); }
     static void OpenURL(const std::string& url);
 
+    // Methods of the Lua Actor type, which wraps a handle. Stale handles return nil
+    static bool ActorIsValid(const ActorHandle* handle);
+    static bool ActorEquals(const ActorHandle* handle, const ActorHandle& other);
+    static luabridge::LuaRef ActorGetName(const ActorHandle* handle);
+    static luabridge::LuaRef ActorGetID(const ActorHandle* handle);
+    static luabridge::LuaRef ActorGetComponentByKey(const ActorHandle* handle, const std::string& key);
+    static luabridge::LuaRef ActorGetComponent(const ActorHandle* handle, const std::string& type_name);
+    static luabridge::LuaRef ActorGetComponents(const ActorHandle* handle, const std::string& type_name);
+    static luabridge::LuaRef ActorAddComponent(const ActorHandle* handle, const std::string& type_name);
+    static void ActorRemoveComponent(const ActorHandle* handle, luabridge::LuaRef component_ref);
+    static luabridge::LuaRef ActorGetTags(const ActorHandle* handle);
+    static bool ActorHasTags(const ActorHandle* handle, uint32_t mask);
+    static void ActorSetTags(const ActorHandle* handle, uint32_t mask);
+    static void ActorAddTags(const ActorHandle* handle, uint32_t mask);
+    static void ActorRemoveTags(const ActorHandle* handle, uint32_t mask);
+    static luabridge::LuaRef ActorGetLayer(const ActorHandle* handle);
+    static void ActorSetLayer(const ActorHandle* handle, const std::string& layer_name);
+    static void ActorSetPosition(const ActorHandle* handle, float x, float y);
+    static luabridge::LuaRef ActorGetPosition(const ActorHandle* handle);
+    static void ActorClearPosition(const ActorHandle* handle);
+
     static bool GetKey(const std::string& keycode);
     static bool GetKeyDown(const std::string& keycode);
     static bool GetKeyUp(const std::string& keycode);
 
+    // Vector2 is plain math, script shards get the same binding
+    static void InitVector2(lua_State* L);
+
 private:
     static void InitState();
     static void InitFunctions();
 };
 
+class Collision;
+struct ShardInstance;
+
 class Component
 {
 public:
     explicit Component();
+    explicit Component(luabridge::LuaRef instance);
+    Component(Component&& other) = default;
     Component& operator=(const Component& parent_component);
+    Component& operator=(Component&& other) = default;
+
+    bool IsEnabled() const { return *enabled; }
+    bool HasHook(ComponentHook hook) const { return hooks && hooks->functions[hook] != LUA_NOREF; }
+    bool IsParallel() const { return hooks && hooks->parallel; }
+
+    void Call(ComponentHook hook, const std::string& actor_name);
+    void Call(ComponentHook hook, const std::string& actor_name, Collision& collision);
+    void Call(ComponentHook hook, const std::string& actor_name, int frames);
 
-    bool IsEnabled() const;
+    const std::string& GetType() const { return ComponentDB::GetTypeName(type_id); }
 
     std::shared_ptr<luabridge::LuaRef> component_ref;
-    std::string type;
 
-    bool has_start;
-    bool has_update;
-    bool has_late_update;
+    // Instance in a script shard for parallel types, built when the component first runs.
+    // Its lifecycle functions run there and component_ref only holds the fields it was created with
+    std::shared_ptr<ShardInstance> shard_instance;
 
-    bool has_collision_enter;
-    bool has_collision_exit;
-    bool has_trigger_enter;
-    bool has_trigger_exit;
+    std::string key;
+    int type_id;
 
-    bool has_destroy;
+    // Shared by every component of this type, owned by ComponentDB
+    const ComponentHooks* hooks;
 
+    // Mirrors the Lua enabled field, kept in sync by the instance __newindex
+    bool* enabled;
+
+    bool started;
     bool alive;
+
+    // Position in each scene hook list, -1 when not registered
+    int dispatch_slots[HOOK_COUNT];
+    int dispatch_buckets[HOOK_COUNT];
+
+    // Position in the scene's component index, -1 when not registered
+    int index_slot;
+
+    // Position in the scene's update LOD list, -1 when not registered, and whether it updates at its far rate
+    int lod_slot;
+    bool lod_far;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,333 @@
+#include "CoroutineScheduler.h"
+
+#include "ActorPool.h"
+#include "ComponentDB.h"
+#include "EngineUtils.h"
+#include "Timestep.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Schedule an id, ticks that already passed fire on the next advance
+void TimingWheel::Add(int id, uint64_t tick)
+{
+    tick = std::max(tick, current + 1);
+    slots[tick % SLOT_COUNT].push_back({ id, tick });
+}
+
+// Move to to_tick and append every id whose tick has been reached
+void TimingWheel::Advance(uint64_t to_tick, std::vector<int>& due)
+{
+    if (to_tick <= current)
+        return;
+
+    // A jump of more than a full turn visits every slot once
+    if (to_tick - current >= SLOT_COUNT)
+    {
+        for (std::vector<Entry>& slot : slots)
+            Collect(slot, to_tick, due);
+        current = to_tick;
+        return;
+    }
+
+    while (current < to_tick)
+    {
+        current++;
+        Collect(slots[current % SLOT_COUNT], to_tick, due);
+    }
+}
+
+// Take the due entries out of a slot, keeping the rest in order
+void TimingWheel::Collect(std::vector<Entry>& slot, uint64_t to_tick, std::vector<int>& due)
+{
+    size_t kept = 0;
+    for (const Entry& e : slot)
+    {
+        if (e.tick <= to_tick)
+            due.push_back(e.id);
+        else
+            slot[kept++] = e;
+    }
+    slot.resize(kept);
+}
+
+void TimingWheel::Clear()
+{
+    for (std::vector<Entry>& slot : slots)
+        slot.clear();
+    current = 0;
+}
+
+// Resume every coroutine whose wait is over, ones that wait again are due on a later update
+void CoroutineScheduler::Update()
+{
+    time += Timestep::GetDeltaTime();
+
+    static std::vector<int> due;
+    due.clear();
+
+    frame_wheel.Advance(frame, due);
+    time_wheel.Advance(static_cast<uint64_t>(time / SECONDS_PER_TICK), due);
+
+    due.insert(due.end(), signalled.begin(), signalled.end());
+    signalled.clear();
+
+    for (int id : due)
+        Resume(id, lua_state);
+
+    frame++;
+}
+
+// Forget every coroutine without touching the Lua state, it may already have been replaced
+void CoroutineScheduler::Clear()
+{
+    routines.clear();
+    running_id = 0;
+    frame = 0;
+    time = 0.0;
+    frame_wheel.Clear();
+    time_wheel.Clear();
+    event_waiters.clear();
+    owned_routines.clear();
+    signalled.clear();
+}
+
+// Finish the owner's coroutines right away, so ones waiting on a late or missing event or a long
+// Wait.Seconds do not keep their closures alive. A running one ends at its next wait
+void CoroutineScheduler::StopOwned(ActorHandle owner)
+{
+    auto it = owned_routines.find(owner.index);
+    if (it == owned_routines.end())
+        return;
+
+    static std::vector<int> stopping;
+    stopping.clear();
+    for (int id : it->second)
+    {
+        Routine& routine = routines.at(id);
+        if (routine.owner != owner)
+            continue;
+
+        if (routine.running)
+            routine.stopped = true;
+        else
+            stopping.push_back(id);
+    }
+
+    for (int id : stopping)
+        Finish(id);
+}
+
+// Queue the coroutines waiting for an event, each keeps a reference to the event object
+void CoroutineScheduler::Signal(const std::string& event_type, luabridge::LuaRef event_object)
+{
+    auto it = event_waiters.find(event_type);
+    if (it == event_waiters.end() || it->second.empty())
+        return;
+
+    for (int id : it->second)
+    {
+        auto routine = routines.find(id);
+        if (routine == routines.end())
+            continue;
+
+        event_object.push(lua_state);
+        routine->second.event_ref = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+        routine->second.event_type.clear();
+        signalled.push_back(id);
+    }
+    it->second.clear();
+}
+
+// Create a coroutine from fn and run it until its first wait, returns its id
+int CoroutineScheduler::Start(lua_State* L)
+{
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+
+    ActorHandle owner;
+    bool owned = !lua_isnoneornil(L, 2);
+    if (owned)
+        owner = luabridge::Stack<ActorHandle>::get(L, 2);
+
+    lua_State* thread = lua_newthread(L);
+    int thread_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_pushvalue(L, 1);
+    lua_xmove(L, thread, 1);
+
+    int id = next_id++;
+    routines.emplace(id, Routine{ thread, thread_ref, owner, owned });
+    if (owned)
+        owned_routines[owner.index].push_back(id);
+    Resume(id, L);
+
+    lua_pushinteger(L, id);
+    return 1;
+}
+
+// Stop a coroutine, one that stops itself ends at its next wait
+int CoroutineScheduler::Stop(lua_State* L)
+{
+    int id = static_cast<int>(luaL_checkinteger(L, 1));
+
+    auto it = routines.find(id);
+    if (it == routines.end())
+        return 0;
+
+    if (it->second.running)
+        it->second.stopped = true;
+    else
+        Finish(id);
+    return 0;
+}
+
+// Sleep for n updates, 1 by default
+int CoroutineScheduler::WaitFrames(lua_State* L)
+{
+    int id = Running(L);
+    lua_Integer frames = std::max<lua_Integer>(1, luaL_optinteger(L, 1, 1));
+
+    routines.at(id).waiting = true;
+    frame_wheel.Add(id, frame + static_cast<uint64_t>(frames));
+    return lua_yield(L, 0);
+}
+
+// Sleep for at least t seconds of frame time
+int CoroutineScheduler::WaitSeconds(lua_State* L)
+{
+    int id = Running(L);
+    double seconds = std::max(0.0, static_cast<double>(luaL_checknumber(L, 1)));
+
+    routines.at(id).waiting = true;
+    time_wheel.Add(id, static_cast<uint64_t>(std::ceil((time + seconds) / SECONDS_PER_TICK)));
+    return lua_yield(L, 0);
+}
+
+// Sleep until the event is published, Wait.Event returns the event object
+int CoroutineScheduler::WaitEvent(lua_State* L)
+{
+    int id = Running(L);
+    std::string event_type = luaL_checkstring(L, 1);
+
+    Routine& routine = routines.at(id);
+    routine.waiting = true;
+    routine.event_type = event_type;
+    event_waiters[event_type].push_back(id);
+    return lua_yield(L, 0);
+}
+
+// Id of the coroutine that L belongs to, raises a Lua error outside of one
+int CoroutineScheduler::Running(lua_State* L)
+{
+    auto it = routines.find(running_id);
+    if (it == routines.end() || it->second.thread != L)
+        luaL_error(L, "Wait can only be used inside a coroutine started with Coroutine.Start");
+    return running_id;
+}
+
+// Run a coroutine until it waits, ends or fails. A plain coroutine.yield waits one frame
+void CoroutineScheduler::Resume(int id, lua_State* from)
+{
+    auto it = routines.find(id);
+    if (it == routines.end())
+        return;
+    Routine& routine = it->second;
+
+    if (routine.owned)
+    {
+        Actor* owner = ActorPool::Resolve(routine.owner);
+        if (!owner || !owner->IsAlive())
+        {
+            Finish(id);
+            return;
+        }
+    }
+
+    int arg_count = 0;
+    if (routine.event_ref != LUA_NOREF)
+    {
+        lua_rawgeti(routine.thread, LUA_REGISTRYINDEX, routine.event_ref);
+        luaL_unref(lua_state, LUA_REGISTRYINDEX, routine.event_ref);
+        routine.event_ref = LUA_NOREF;
+        arg_count = 1;
+    }
+
+    int previous_id = running_id;
+    running_id = id;
+    routine.waiting = false;
+    routine.running = true;
+
+    int result_count = 0;
+    int status = lua_resume(routine.thread, from, arg_count, &result_count);
+
+    running_id = previous_id;
+    routine.running = false;
+
+    if (status == LUA_YIELD)
+    {
+        lua_pop(routine.thread, result_count);
+        if (routine.stopped)
+            Finish(id);
+        else if (!routine.waiting)
+            frame_wheel.Add(id, frame + 1);
+        return;
+    }
+
+    if (status != LUA_OK)
+    {
+        const char* message = lua_tostring(routine.thread, -1);
+        EngineUtils::ReportError(GetOwnerName(routine), message ? message : "error object is not a string");
+    }
+    Finish(id);
+}
+
+// Drop a coroutine and its event and owner entries, wheel entries left behind are skipped when they come up
+void CoroutineScheduler::Finish(int id)
+{
+    auto it = routines.find(id);
+    if (it == routines.end())
+        return;
+    Routine& routine = it->second;
+
+    luaL_unref(lua_state, LUA_REGISTRYINDEX, routine.thread_ref);
+    if (routine.event_ref != LUA_NOREF)
+        luaL_unref(lua_state, LUA_REGISTRYINDEX, routine.event_ref);
+
+    if (!routine.event_type.empty())
+    {
+        auto waiters = event_waiters.find(routine.event_type);
+        if (waiters != event_waiters.end())
+            EraseId(waiters->second, id);
+    }
+
+    if (routine.owned)
+    {
+        auto owned = owned_routines.find(routine.owner.index);
+        if (owned != owned_routines.end())
+        {
+            EraseId(owned->second, id);
+            if (owned->second.empty())
+                owned_routines.erase(owned);
+        }
+    }
+
+    routines.erase(it);
+}
+
+// Lists are short and their order does not matter, so swap the id with the last one
+void CoroutineScheduler::EraseId(std::vector<int>& ids, int id)
+{
+    auto it = std::find(ids.begin(), ids.end(), id);
+    if (it == ids.end())
+        return;
+
+    *it = ids.back();
+    ids.pop_back();
+}
+
+std::string CoroutineScheduler::GetOwnerName(const Routine& routine)
+{
+    if (routine.owned)
+        if (Actor* owner = ActorPool::Resolve(routine.owner))
+            return owner->GetName();
+    return "Coroutine";
+}
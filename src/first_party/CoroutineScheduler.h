@@ -0,0 +1,107 @@
+#ifndef COROUTINE_SCHEDULER_H
+#define COROUTINE_SCHEDULER_H
+
+#include "ActorHandle.h"
+
+#include "lua/lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Hashed timing wheel of coroutine ids. An Advance only looks at the slots of the ticks it passes,
+// entries more than one turn away stay in their slot until their tick comes around
+class TimingWheel
+{
+public:
+    void Add(int id, uint64_t tick);
+    void Advance(uint64_t to_tick, std::vector<int>& due);
+    void Clear();
+
+    uint64_t GetCurrent() const { return current; }
+
+private:
+    struct Entry
+    {
+        int id;
+        uint64_t tick;
+    };
+
+    void Collect(std::vector<Entry>& slot, uint64_t to_tick, std::vector<int>& due);
+
+    static constexpr uint64_t SLOT_COUNT = 256;
+    std::vector<Entry> slots[SLOT_COUNT];
+    uint64_t current = 0;
+};
+
+// Lua coroutines run by the engine once per frame, after LateUpdate. A coroutine that waits sits in a
+// timing wheel or an event's waiting list and costs nothing until it is due
+class CoroutineScheduler
+{
+public:
+    static void Update();
+    static void Clear();
+
+    // Stop the coroutines started with this actor as their owner, called once it is destroyed or released
+    static void StopOwned(ActorHandle owner);
+
+    // Resume the coroutines waiting for an event, at the next Update
+    static void Signal(const std::string& event_type, luabridge::LuaRef event_object);
+
+    // Lua: Coroutine.Start(fn [, owner]) and Coroutine.Stop(id)
+    static int Start(lua_State* L);
+    static int Stop(lua_State* L);
+
+    // Lua: Wait.Frames(n), Wait.Seconds(t) and Wait.Event(name), only inside a coroutine
+    static int WaitFrames(lua_State* L);
+    static int WaitSeconds(lua_State* L);
+    static int WaitEvent(lua_State* L);
+
+private:
+    struct Routine
+    {
+        lua_State* thread;
+        int thread_ref;
+
+        // Coroutines started with an owner stop once that actor is destroyed or released
+        ActorHandle owner;
+        bool owned;
+
+        // Event whose waiting list holds the coroutine, and the value handed to Wait.Event's caller
+        std::string event_type = {};
+        int event_ref = LUA_NOREF;
+
+        bool waiting = false;
+        bool running = false;
+        bool stopped = false;
+    };
+
+    static int Running(lua_State* L);
+    static void Resume(int id, lua_State* from);
+    static void Finish(int id);
+    static void EraseId(std::vector<int>& ids, int id);
+    static std::string GetOwnerName(const Routine& routine);
+
+    // Wait.Seconds wakes on the first update at or after the requested time, rounded up to this step
+    static constexpr double SECONDS_PER_TICK = 0.01;
+
+    static inline std::unordered_map<int, Routine> routines;
+    static inline int next_id = 1;
+    static inline int running_id = 0;
+
+    // Updates run so far and the summed frame time at the last one
+    static inline uint64_t frame = 0;
+    static inline double time = 0.0;
+    static inline TimingWheel frame_wheel;
+    static inline TimingWheel time_wheel;
+
+    static inline std::unordered_map<std::string, std::vector<int>> event_waiters;
+    static inline std::vector<int> signalled;
+
+    // Owned coroutine ids by their owner's pool index
+    static inline std::unordered_map<uint32_t, std::vector<int>> owned_routines;
+};
+
+#endif
@@ -84,7 +84,7 @@ void EditorManager::ShowSceneHierarchy()
 
             // Delete actor button
             if (ImGui::Button("Delete"))
-                SceneDB::Destroy(actor);
+                SceneDB::Destroy(actor->GetHandle());
 
             ImGui::SameLine();
 
@@ -92,10 +92,8 @@ void EditorManager::ShowSceneHierarchy()
             ActorSaveToTemplateButton(actor);
 
             // Inputs for all components
-            for (const auto& pair : actor->actor_components)
+            for (const Component& c : actor->components)
             {
-                const Component& c = pair.second;
-
                 if (!c.alive)
                     continue;
 
@@ -103,14 +101,14 @@ void EditorManager::ShowSceneHierarchy()
                 ImGui::PushID(c.component_ref.get());
 
                 // Enabled checkbox
-                bool enabled = (*c.component_ref)["enabled"];
+                bool enabled = c.IsEnabled();
                 if (ImGui::Checkbox("##enabled", &enabled))
                     (*c.component_ref)["enabled"] = enabled;
 
                 ImGui::SameLine();
                 
                 // Expandable node for each component
-                if (ImGui::TreeNode(c.type.c_str()))
+                if (ImGui::TreeNode(c.GetType().c_str()))
                 {
                     ImGui::Text("key:");
                     ImGui::SameLine();
@@ -128,7 +126,7 @@ void EditorManager::ShowSceneHierarchy()
                     if (ImGui::Button("Delete"))
                         actor->RemoveComponent(*c.component_ref);
 
-                    ShowComponent(*c.component_ref, c.type);
+                    ShowComponent(*c.component_ref, c.GetType());
                     ImGui::TreePop();
                 }
                 ImGui::PopID();
@@ -169,7 +167,12 @@ void EditorManager::ActorNameBox(Actor* actor)
     ImGui::InputText(label.c_str(), str, 50);
 
     if (ImGui::IsItemDeactivatedAfterEdit())
+    {
+        // Keep the name lookup in step so reclaiming the actor can find it
+        SceneDB::name_to_actor[actor->actor_name].erase(actor);
         actor->actor_name = std::string(str);
+        SceneDB::name_to_actor[actor->actor_name].insert(actor);
+    }
 }
 
 void EditorManager::ActorSaveToTemplateButton(Actor* actor)
@@ -414,10 +417,8 @@ void EditorManager::ActorToJson(const Actor* a, rapidjson::Value& a_json, rapidj
     rapidjson::Value components(rapidjson::kObjectType);
 
     // Loop through components in order of key
-    for (const auto& pair : a->actor_components)
+    for (const Component& c : a->components)
     {
-        const auto& c = pair.second;
-
         if (!c.alive)
             continue;
 
@@ -425,7 +426,7 @@ void EditorManager::ActorToJson(const Actor* a, rapidjson::Value& a_json, rapidj
         rapidjson::Value c_json(rapidjson::kObjectType);
 
         // Add type and enabled at the top
-        c_json.AddMember("type", rapidjson::Value(c.type.c_str(), allocator), allocator);
+        c_json.AddMember("type", rapidjson::Value(c.GetType().c_str(), allocator), allocator);
         if (!c.IsEnabled())
             c_json.AddMember("enabled", false, allocator);
 
@@ -6,16 +6,40 @@
 #include "EventBus.h"
 #include "ImageDB.h"
 #include "Input.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 #include "SceneDB.h"
+#include "ScriptGC.h"
+#include "ScriptMemory.h"
+#include "ScriptProfiler.h"
+#include "ScriptReloader.h"
+#include "ScriptShards.h"
 #include "Renderer.h"
 #include "Rigidbody.h"
+#include "TagDB.h"
 #include "TextDB.h"
 #include "TemplateDB.h"
+#include "Timestep.h"
 
 #include "Helper.h"
 #include "SDL_ttf/SDL_ttf.h"
 
 
+// Read command line flags: --headless, --frames N
+void Engine::ParseArguments(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--headless")
+            headless = true;
+        else if (arg == "--frames" && i + 1 < argc)
+            max_frames = std::atoi(argv[++i]);
+        else
+            std::cout << "warning: unknown argument " << arg << std::endl;
+    }
+}
+
 // Game loop for engine
 void Engine::GameLoop()
 {
@@ -23,26 +47,65 @@ void Engine::GameLoop()
 
     while (game_running)
     {
+        PROFILE_ZONE("Frame");
+
         ProcessInput();
 
+        // Completions posted by jobs since the last frame
+        JobSystem::RunMainThreadTasks();
+
+        // Component scripts saved since the last frame
+        ScriptReloader::Poll();
+
+        Timestep::BeginFrame();
+
+        if (!headless)
+        {
 #ifndef NDEBUG
-        EditorManager::Get()->ShowEditor();
+            EditorManager::Get()->ShowEditor();
 #endif
+            Renderer::RenderClear();
+        }
 
-        Renderer::RenderClear();
-        
         SceneDB::UpdateActors();
 
         EventBus::ProcessSubscriptions();
-        
-        Rigidbody::PhysicsStep();
 
-        Renderer::Present();
+        // Run as many fixed simulation steps as the elapsed time calls for
+        while (Timestep::StepFixed())
+        {
+            SceneDB::FixedUpdateActors();
+            Rigidbody::PhysicsStep();
+        }
+
+        // Headless frames are not presented, so count them here
+        if (headless)
+            Helper::frame_number++;
+        else
+            Renderer::Present();
+
+        // Lua garbage collection between frames, so it never interrupts the scripts
+        ScriptGC::Step();
+        ScriptMemory::EndFrame();
+
+        if (max_frames >= 0 && Helper::frame_number >= max_frames)
+            game_running = false;
         
         if (!SceneDB::next_scene.empty())
             SceneDB::LoadScene(SceneDB::next_scene);
     }
 
+    Shutdown();
+}
+
+// Tear down editor and SDL
+void Engine::Shutdown()
+{
+    JobSystem::Shutdown();
+
+    if (headless)
+        return;
+
 #ifndef NDEBUG
     ImGui_ImplSDLRenderer2_Shutdown();
     ImGui_ImplSDL2_Shutdown();
@@ -58,20 +121,40 @@ void Engine::GameLoop()
 void Engine::LoadInitialSettings()
 {
     CheckForFiles();
+    Profiler::Init();
+    ScriptProfiler::Init();
 
     // Read game.config json
     rapidjson::Document doc;
     EngineUtils::ReadJsonFile("resources/game.config", doc);
 
-    RendererInit(doc);
-    ImageDB::Init();
-    AudioDB::Init();
-    TextDB::Init();
+    Timestep::Init(doc);
+    TagDB::Init(doc);
+    SceneDB::Init(doc);
+    JobSystem::Init(doc);
+    ScriptGC::Init(doc);
+    ScriptShards::Init(doc);
+    ScriptReloader::Init(doc);
+    if (headless)
+    {
+        // Run as fast as possible, one simulation step per frame
+        Timestep::SetLockstep(true);
+        Helper::frame_pacing = false;
+        SceneDB::stopped = false;
+    }
+    else
+    {
+        RendererInit(doc);
+        ImageDB::Init();
+        AudioDB::Init();
+        TextDB::Init();
+    }
     ComponentManager::Init();
 
 #ifndef NDEBUG
     TemplateDB::LoadAll();
-    EditorManager::Get()->Init();
+    if (!headless)
+        EditorManager::Get()->Init();
 #endif
         
     // Pull initial scene from json
@@ -104,19 +187,31 @@ void Engine::CheckForFiles()
     }
 }
 
-// Get game title, initalize renderer with game_title
+// Get game title and frame pacing, initalize renderer with game_title
 void Engine::RendererInit(rapidjson::Document& doc)
 {
     std::string game_title = "";
     EngineUtils::GetConfigValue(doc, "game_title", game_title);
+
+    // Presentation is paced by vsync unless the game asks for the fixed 16ms frame sleep
+    bool frame_pacing = false;
+    EngineUtils::GetConfigValue(doc, "frame_pacing", frame_pacing);
+    Helper::frame_pacing = frame_pacing;
+
     Renderer::Init(game_title);
 }
 
 // Prompt user for input then process it
 void Engine::ProcessInput()
 {
+    PROFILE_ZONE("Engine::ProcessInput");
+
     Input::LateUpdate();
 
+    // There is no window to receive events from
+    if (headless)
+        return;
+
     SDL_Event e;
     while (Helper::SDL_PollEvent(&e))
     {
@@ -6,16 +6,22 @@
 class Engine
 {
 public:
+    void ParseArguments(int argc, char* argv[]);
     void GameLoop();
 
+    // No window, renderer, editor or audio. Draw and audio calls become no-ops
+    static inline bool headless = false;
+
 private:
     void LoadInitialSettings();
     void CheckForFiles();
     void RendererInit(rapidjson::Document& doc);
 
     void ProcessInput();
+    void Shutdown();
 
     bool game_running = true;
+    int max_frames = -1;
 };
 
 #endif
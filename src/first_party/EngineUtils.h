@@ -105,8 +105,11 @@ public:
 	// Report an error
 	static void ReportError(const std::string& actor_name, const luabridge::LuaException& e)
 	{
-		std::string error_msg = e.what();
+		ReportError(actor_name, std::string(e.what()));
+	}
 
+	static void ReportError(const std::string& actor_name, std::string error_msg)
+	{
 		// Normalize file paths across platforms
 		std::replace(error_msg.begin(), error_msg.end(), '\\', '/');
 
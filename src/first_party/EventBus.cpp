@@ -1,7 +1,15 @@
 #include "EventBus.h"
 
+#include "CoroutineScheduler.h"
+#include "Profiler.h"
+#include "ScriptMemory.h"
+#include "ScriptShards.h"
+
 void EventBus::Publish(std::string event_type, luabridge::LuaRef event_object)
 {
+    CoroutineScheduler::Signal(event_type, event_object);
+    ScriptShards::Forward(event_type, event_object);
+
     auto it = topics.find(event_type);
     if (it == topics.end())
         return;
@@ -25,6 +33,8 @@ void EventBus::Unsubscribe(std::string event_type, luabridge::LuaRef component_r
 
 void EventBus::ProcessSubscriptions()
 {
+    PROFILE_ZONE("EventBus::ProcessSubscriptions");
+
     for (auto& sub : subscriptions_to_add)
     {
         topics[sub.event_type].push_back(std::move(sub));
@@ -45,6 +55,8 @@ void EventBus::ProcessSubscriptions()
 
 Subscription::Subscription(const std::string& event, luabridge::LuaRef& component, luabridge::LuaRef& foo)
 {
+    ScriptMemory::Scope memory_scope(MEMORY_EVENTS);
+
     event_type = event;
     component_ref = std::make_shared<luabridge::LuaRef>(component);
     function = std::make_shared<luabridge::LuaRef>(foo);
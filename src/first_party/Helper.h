@@ -48,6 +48,9 @@ public:
 	/* The frame_number advances with every call to Helper::SDL_RenderPresent() */
 	static inline int frame_number = 0;
 	static inline Uint32 current_frame_start_timestamp = 0;
+
+	/* Sleep out the rest of a 16ms frame in SDL_RenderPresent. Turn off to let vsync pace presentation. */
+	static inline bool frame_pacing = true;
 	static int GetFrameNumber() { return frame_number; }
 
 	static SDL_Window* SDL_CreateWindow(const char* title, int x, int y, int w, int h, Uint32 flags)
@@ -402,7 +405,7 @@ private:
 	/* If the engine detects it is being autograded, it will run as fast as possible. */
 	static void SDL_Delay() {
 
-		if (_autograder_mode)
+		if (_autograder_mode || !frame_pacing)
 		{
 			//::SDL_Delay(1); Don't bother delaying at all. Gotta go fast when autograding.
 		}
@@ -0,0 +1,125 @@
+#include "HookList.h"
+
+#include "Actor.h"
+
+// Append component to its bucket, remembering where it went for removal
+void HookList::Add(Actor* actor, Component* component, int interval)
+{
+    if (component->dispatch_slots[hook] != -1)
+        return;
+
+    int bucket_index = PickBucket(interval);
+    Bucket& bucket = buckets[bucket_index];
+
+    component->dispatch_buckets[hook] = bucket_index;
+    component->dispatch_slots[hook] = static_cast<int>(bucket.entries.size());
+    bucket.entries.push_back({ actor, component, run_count - 1 });
+    bucket.live++;
+}
+
+// Leave a hole in the component's slot
+void HookList::Remove(Component* component)
+{
+    int slot = component->dispatch_slots[hook];
+    if (slot == -1)
+        return;
+
+    Bucket& bucket = buckets[component->dispatch_buckets[hook]];
+    bucket.entries[slot].component = nullptr;
+    bucket.live--;
+    bucket.has_holes = true;
+
+    component->dispatch_slots[hook] = -1;
+}
+
+// Point the component's slot at its new address after its owner's storage moved
+void HookList::Relocate(Component* component)
+{
+    int slot = component->dispatch_slots[hook];
+    if (slot != -1)
+        buckets[component->dispatch_buckets[hook]].entries[slot].component = component;
+}
+
+// Move a registered component to a bucket of another interval, keeping when it last ran
+void HookList::SetInterval(Component* component, int interval)
+{
+    int slot = component->dispatch_slots[hook];
+    if (slot == -1)
+        return;
+
+    Entry e = buckets[component->dispatch_buckets[hook]].entries[slot];
+    Remove(component);
+
+    int bucket_index = PickBucket(interval);
+    Bucket& bucket = buckets[bucket_index];
+
+    component->dispatch_buckets[hook] = bucket_index;
+    component->dispatch_slots[hook] = static_cast<int>(bucket.entries.size());
+    bucket.entries.push_back(e);
+    bucket.live++;
+}
+
+void HookList::Clear()
+{
+    for (Bucket& bucket : buckets)
+        for (Entry& e : bucket.entries)
+            if (e.component)
+                e.component->dispatch_slots[hook] = -1;
+
+    buckets = { Bucket{ 1, 0 }, Bucket{ 0, 0 } };
+}
+
+size_t HookList::Size() const
+{
+    size_t size = 0;
+    for (const Bucket& bucket : buckets)
+        size += bucket.live;
+    return size;
+}
+
+// Least filled bucket of an interval, creating the interval's buckets on first use
+int HookList::PickBucket(int interval)
+{
+    if (interval == 1)
+        return 0;
+    if (interval <= 0)
+        return 1;
+
+    int best = -1;
+    for (int i = 2; i < static_cast<int>(buckets.size()); i++)
+        if (buckets[i].interval == interval && (best == -1 || buckets[i].live < buckets[best].live))
+            best = i;
+
+    if (best != -1)
+        return best;
+
+    best = static_cast<int>(buckets.size());
+    for (int phase = 0; phase < interval; phase++)
+        buckets.push_back(Bucket{ interval, phase });
+    return best;
+}
+
+void HookList::Run()
+{
+    Run([this](Actor* actor, Component& component, int frames) {
+        actor->RunHook(component, hook, frames);
+    });
+}
+
+// Close holes without reordering the remaining entries
+void HookList::Compact(Bucket& bucket)
+{
+    size_t j = 0;
+    for (size_t i = 0; i < bucket.entries.size(); i++)
+    {
+        if (!bucket.entries[i].component)
+            continue;
+
+        bucket.entries[j] = bucket.entries[i];
+        bucket.entries[j].component->dispatch_slots[hook] = static_cast<int>(j);
+        j++;
+    }
+
+    bucket.entries.resize(j);
+    bucket.has_holes = false;
+}
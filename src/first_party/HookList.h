@@ -0,0 +1,109 @@
+#ifndef HOOK_LIST_H
+#define HOOK_LIST_H
+
+#include "ComponentManager.h"
+
+#include <cstdint>
+#include <vector>
+
+class Actor;
+
+// Dense lists of the live components that implement one lifecycle function.
+// Removal leaves a hole that is compacted after the next run, so call order stays stable.
+// Components with an interval above 1 are spread over that many buckets, one of which runs per frame,
+// and interval 0 suspends a component until it is given another interval
+class HookList
+{
+public:
+    explicit HookList(ComponentHook hook_type) : hook(hook_type) { }
+
+    void Add(Actor* actor, Component* component, int interval = 1);
+    void Remove(Component* component);
+    void Relocate(Component* component);
+    void SetInterval(Component* component, int interval);
+    void Clear();
+
+    void Run();
+
+    // Same walk, but each due entry is handed to call(actor, component, frames) instead of Actor::RunHook
+    template <typename Call>
+    void Run(Call call);
+
+    size_t Size() const;
+
+private:
+    struct Entry
+    {
+        Actor* actor = nullptr;
+        Component* component = nullptr;
+
+        // Run count when the component last ran, the hook gets the runs since then.
+        // Components count as having run the frame before they joined
+        int64_t last_run = 0;
+    };
+
+    struct Bucket
+    {
+        Bucket(int bucket_interval, int bucket_phase) : interval(bucket_interval), phase(bucket_phase) { }
+
+        int interval;
+        int phase;
+        std::vector<Entry> entries;
+        int live = 0;
+        bool has_holes = false;
+    };
+
+    int PickBucket(int interval);
+    void Compact(Bucket& bucket);
+
+    ComponentHook hook;
+
+    // The first bucket holds every component that runs each frame, the second suspended ones
+    std::vector<Bucket> buckets = { Bucket{ 1, 0 }, Bucket{ 0, 0 } };
+    int64_t run_count = 0;
+
+    // Bucket sizes when the current run started, lists of different shards run at the same time
+    std::vector<size_t> run_sizes;
+};
+
+// Call the hook on every enabled entry of the buckets due this frame, with the runs since each one's last call.
+// Entries added during the run wait for the next one
+template <typename Call>
+void HookList::Run(Call call)
+{
+    run_sizes.clear();
+    for (const Bucket& bucket : buckets)
+        run_sizes.push_back(bucket.entries.size());
+
+    for (size_t b = 0; b < run_sizes.size(); b++)
+    {
+        // Suspended components never run, so their bucket is compacted here or it would only ever grow
+        if (buckets[b].interval == 0)
+        {
+            if (buckets[b].has_holes)
+                Compact(buckets[b]);
+            continue;
+        }
+
+        if (run_count % buckets[b].interval != buckets[b].phase)
+            continue;
+
+        for (size_t i = 0; i < run_sizes[b]; i++)
+        {
+            Entry& slot = buckets[b].entries[i];
+            Entry e = slot;
+            slot.last_run = run_count;
+            if (!e.component || !e.component->IsEnabled())
+                continue;
+
+            call(e.actor, *e.component, static_cast<int>(run_count - e.last_run));
+        }
+
+        if (buckets[b].has_holes)
+            Compact(buckets[b]);
+    }
+
+    run_count++;
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "ImageDB.h"
 
+#include "Engine.h"
 #include "Renderer.h"
 
 #include <filesystem>
@@ -39,7 +40,8 @@ Image& ImageDB::GetImage(const std::string& image_name)
 
 void ImageDB::CreateDefaultParticleTextureWithName(const std::string& name)
 {
-    if (loaded_images.find(name) != loaded_images.end())
+    // No renderer to create textures with, particles are never drawn
+    if (Engine::headless || loaded_images.find(name) != loaded_images.end())
         return;
 
     SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 8, 8, 32, SDL_PIXELFORMAT_RGBA8888);
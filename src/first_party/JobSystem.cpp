@@ -0,0 +1,234 @@
+#include "JobSystem.h"
+
+#include "EngineUtils.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Start one worker per spare core, or the number set by worker_threads in game.config.
+// The workers are also stopped at exit, since errors leave through exit(0)
+void JobSystem::Init(const rapidjson::Document& doc)
+{
+    int worker_threads = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    EngineUtils::GetConfigValue(doc, "worker_threads", worker_threads);
+    worker_threads = std::clamp(worker_threads, 0, 63);
+
+    running = true;
+    queues.clear();
+    for (int i = 0; i <= worker_threads; i++)
+        queues.push_back(std::make_unique<Queue>());
+
+    for (int i = 1; i <= worker_threads; i++)
+        workers.emplace_back(&JobSystem::WorkerLoop, i);
+
+    std::atexit(&JobSystem::Shutdown);
+}
+
+// Wake every worker and wait for them to leave, jobs still queued are dropped
+void JobSystem::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        running = false;
+    }
+    wake.notify_all();
+
+    for (std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+}
+
+// Queue a job on the calling thread's queue. counter, if given, is decremented once it has run
+void JobSystem::Submit(Task task, Counter* counter)
+{
+    if (workers.empty())
+    {
+        task();
+        if (counter)
+            counter->fetch_sub(1);
+        return;
+    }
+
+    Queue& queue = *queues[queue_index];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back({ std::move(task), counter });
+    }
+    queued_jobs.fetch_add(1);
+
+    // Taking the lock orders the count with a worker about to sleep
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wake.notify_one();
+}
+
+// Help with queued jobs until the counter drops to zero
+void JobSystem::Wait(Counter& counter)
+{
+    Job job;
+    while (counter.load() > 0)
+    {
+        if (PopOrSteal(job))
+            Execute(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::ParallelFor(size_t count, size_t min_batch, const std::function<void(size_t, size_t)>& fn)
+{
+    if (count == 0)
+        return;
+
+    min_batch = std::max<size_t>(min_batch, 1);
+    size_t max_slices = queues.size() * 4;
+    size_t slices = std::min((count + min_batch - 1) / min_batch, max_slices);
+    if (workers.empty() || slices <= 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    PROFILE_ZONE("JobSystem::ParallelFor");
+
+    size_t slice_size = (count + slices - 1) / slices;
+    Counter counter = 0;
+    for (size_t begin = slice_size; begin < count; begin += slice_size)
+    {
+        size_t end = std::min(begin + slice_size, count);
+        counter.fetch_add(1);
+        Submit([&fn, begin, end]() { fn(begin, end); }, &counter);
+    }
+
+    // The calling thread takes the first slice itself
+    fn(0, std::min(slice_size, count));
+    Wait(counter);
+}
+
+void JobSystem::PostToMain(Task task)
+{
+    std::lock_guard<std::mutex> lock(main_thread_mutex);
+    main_thread_tasks.push_back(std::move(task));
+}
+
+// Run what was posted since the last frame, tasks posted meanwhile wait for the next one
+void JobSystem::RunMainThreadTasks()
+{
+    static std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(main_thread_mutex);
+        std::swap(tasks, main_thread_tasks);
+    }
+
+    for (Task& task : tasks)
+        task();
+    tasks.clear();
+}
+
+// Newest job of our own queue, else the oldest of another thread's
+bool JobSystem::PopOrSteal(Job& job)
+{
+    if (queued_jobs.load() == 0)
+        return false;
+
+    size_t queue_count = queues.size();
+    for (size_t i = 0; i < queue_count; i++)
+    {
+        size_t index = (queue_index + i) % queue_count;
+        Queue& queue = *queues[index];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty())
+            continue;
+
+        if (i == 0)
+        {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+        else
+        {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+        queued_jobs.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::Execute(Job& job)
+{
+    job.task();
+    if (job.counter)
+        job.counter->fetch_sub(1);
+}
+
+void JobSystem::WorkerLoop(int index)
+{
+    queue_index = index;
+
+    Job job;
+    while (true)
+    {
+        if (PopOrSteal(job))
+        {
+            Execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, []() { return !running || queued_jobs.load() > 0; });
+        if (!running)
+            return;
+    }
+}
+
+// Add a node that runs after every node in dependencies, returns its index
+int TaskGraph::Add(JobSystem::Task task, std::initializer_list<int> dependencies)
+{
+    int index = static_cast<int>(nodes.size());
+    Node& node = nodes.emplace_back();
+    node.task = std::move(task);
+
+    for (int dependency : dependencies)
+    {
+        nodes[dependency].dependents.push_back(index);
+        node.dependency_count++;
+    }
+    return index;
+}
+
+// Submit the nodes without dependencies and help until every node has run
+void TaskGraph::Run()
+{
+    if (nodes.empty())
+        return;
+
+    PROFILE_ZONE("TaskGraph::Run");
+
+    JobSystem::Counter counter = static_cast<int>(nodes.size());
+    for (Node& node : nodes)
+        node.pending.store(node.dependency_count);
+
+    for (size_t i = 0; i < nodes.size(); i++)
+        if (nodes[i].dependency_count == 0)
+            Schedule(static_cast<int>(i), &counter);
+
+    JobSystem::Wait(counter);
+}
+
+// Submit a node whose dependencies are done, it schedules its dependents as they become ready
+void TaskGraph::Schedule(int node_index, JobSystem::Counter* counter)
+{
+    JobSystem::Submit([this, node_index, counter]() {
+        Node& node = nodes[node_index];
+        node.task();
+
+        for (int dependent : node.dependents)
+            if (nodes[dependent].pending.fetch_sub(1) == 1)
+                Schedule(dependent, counter);
+    }, counter);
+}
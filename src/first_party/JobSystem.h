@@ -0,0 +1,101 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "rapidjson/document.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool for native engine work. Every thread, the main one included, pushes and
+// pops jobs at the back of its own queue and steals from the front of the others when it runs dry.
+// A job may use a worker lua_State, such as a script shard's, as long as no other job uses it at the
+// same time. The main lua_state, SDL rendering and changes to the scene stay on the main thread, use
+// PostToMain for anything that has to touch them
+class JobSystem
+{
+public:
+    using Task = std::function<void()>;
+
+    // Threads that wait on a counter run other jobs until it reaches zero
+    using Counter = std::atomic<int>;
+
+    static void Init(const rapidjson::Document& doc);
+    static void Shutdown();
+
+    static int GetWorkerCount() { return static_cast<int>(workers.size()); }
+
+    static void Submit(Task task, Counter* counter);
+    static void Wait(Counter& counter);
+
+    // Call fn(begin, end) over [0, count) in slices of at least min_batch items, on the workers and
+    // the calling thread. Runs inline when there are no workers or too few items to split
+    static void ParallelFor(size_t count, size_t min_batch, const std::function<void(size_t, size_t)>& fn);
+
+    // Run a task on the main thread at the start of the next frame, safe to call from any thread
+    static void PostToMain(Task task);
+    static void RunMainThreadTasks();
+
+private:
+    struct Job
+    {
+        Task task;
+        Counter* counter;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    static bool PopOrSteal(Job& job);
+    static void Execute(Job& job);
+    static void WorkerLoop(int queue_index);
+
+    // Queue 0 belongs to the main thread, queue i to worker i - 1
+    static inline std::vector<std::unique_ptr<Queue>> queues;
+    static inline std::vector<std::thread> workers;
+    static inline thread_local int queue_index = 0;
+
+    // Queued jobs not yet taken, workers sleep while it is zero
+    static inline std::atomic<int> queued_jobs = 0;
+    static inline std::mutex sleep_mutex;
+    static inline std::condition_variable wake;
+    static inline bool running = false;
+
+    static inline std::mutex main_thread_mutex;
+    static inline std::vector<Task> main_thread_tasks;
+};
+
+// Jobs with dependencies, built and run within a frame. A node is submitted once every node it
+// depends on has finished, Run returns once all of them have
+class TaskGraph
+{
+public:
+    int Add(JobSystem::Task task, std::initializer_list<int> dependencies = {});
+    void Run();
+    void Clear() { nodes.clear(); }
+
+private:
+    struct Node
+    {
+        JobSystem::Task task;
+        std::vector<int> dependents;
+        int dependency_count = 0;
+        std::atomic<int> pending = 0;
+    };
+
+    void Schedule(int node_index, JobSystem::Counter* counter);
+
+    std::deque<Node> nodes;
+};
+
+#endif
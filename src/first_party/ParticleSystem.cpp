@@ -1,6 +1,7 @@
 #include "ParticleSystem.h"
 
 #include "ImageDB.h"
+#include "JobSystem.h"
 #include "Renderer.h"
 
 #include "glm/glm.hpp"
@@ -34,30 +35,21 @@ void ParticleSystem::OnUpdate()
     if (do_emission && local_frame_number % frames_between_bursts == 0)
         GenerateNewParticles(burst_quantity);
 
+    // Large systems simulate on the job system, drawing and retiring particles stays on this thread
+    draws.resize(num_particle_slots);
+    JobSystem::ParallelFor(num_particle_slots, 2048, [this](size_t begin, size_t end) {
+        Simulate(static_cast<int>(begin), static_cast<int>(end));
+    });
+
     for (int i = 0; i < num_particle_slots; i++)
     {
         if (!is_alive[i])
             continue;
 
-        if (durations[i] < duration_frames)
+        const ParticleDraw& draw = draws[i];
+        if (draw.drawn)
         {
-            float lifetime_progress = static_cast<float>(durations[i]++) / duration_frames;
-
-            x_velocities[i] += gravity_scale_x;
-            y_velocities[i] += gravity_scale_y;
-            x_velocities[i] *= drag_factor;
-            y_velocities[i] *= drag_factor;
-            rotation_velocities[i] *= angular_drag_factor;
-            x_positions[i] += x_velocities[i];
-            y_positions[i] += y_velocities[i];
-            rotations[i] += rotation_velocities[i];
-            float scale = do_end_scale ? glm::mix(start_scales[i], end_scale, lifetime_progress) : start_scales[i];
-            int tint_r = do_tint_r ? glm::mix(start_color_r, end_color_r, lifetime_progress) : start_color_r;
-            int tint_g = do_tint_g ? glm::mix(start_color_g, end_color_g, lifetime_progress) : start_color_g;
-            int tint_b = do_tint_b ? glm::mix(start_color_b, end_color_b, lifetime_progress) : start_color_b;
-            int tint_a = do_tint_a ? glm::mix(start_color_a, end_color_a, lifetime_progress) : start_color_a;
-
-            Renderer::DrawImage(image, x_positions[i], y_positions[i], rotations[i], scale, scale, 0.5f, 0.5f, tint_r, tint_g, tint_b, tint_a, sorting_order);
+            Renderer::DrawImage(image, x_positions[i], y_positions[i], rotations[i], draw.scale, draw.scale, 0.5f, 0.5f, draw.r, draw.g, draw.b, draw.a, sorting_order);
         }
         else
         {
@@ -70,6 +62,37 @@ void ParticleSystem::OnUpdate()
     local_frame_number++;
 }
 
+// Advance the particles in [begin, end) one frame, touching only their own slots
+void ParticleSystem::Simulate(int begin, int end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        if (!is_alive[i])
+            continue;
+
+        ParticleDraw& draw = draws[i];
+        draw.drawn = durations[i] < duration_frames;
+        if (!draw.drawn)
+            continue;
+
+        float lifetime_progress = static_cast<float>(durations[i]++) / duration_frames;
+
+        x_velocities[i] += gravity_scale_x;
+        y_velocities[i] += gravity_scale_y;
+        x_velocities[i] *= drag_factor;
+        y_velocities[i] *= drag_factor;
+        rotation_velocities[i] *= angular_drag_factor;
+        x_positions[i] += x_velocities[i];
+        y_positions[i] += y_velocities[i];
+        rotations[i] += rotation_velocities[i];
+        draw.scale = do_end_scale ? glm::mix(start_scales[i], end_scale, lifetime_progress) : start_scales[i];
+        draw.r = do_tint_r ? glm::mix(start_color_r, end_color_r, lifetime_progress) : start_color_r;
+        draw.g = do_tint_g ? glm::mix(start_color_g, end_color_g, lifetime_progress) : start_color_g;
+        draw.b = do_tint_b ? glm::mix(start_color_b, end_color_b, lifetime_progress) : start_color_b;
+        draw.a = do_tint_a ? glm::mix(start_color_a, end_color_a, lifetime_progress) : start_color_a;
+    }
+}
+
 void ParticleSystem::GenerateNewParticles(int num)
 {
     num_particles += burst_quantity;
@@ -13,7 +13,7 @@ public:
 
     std::string type = "ParticleSystem";
     std::string key = "???";
-    Actor* actor = nullptr;
+    ActorHandle actor;
     bool enabled = true;
 
     float x = 0.0f;
@@ -88,6 +88,16 @@ private:
     std::vector<int> durations;
     std::vector<bool> is_alive;
 
+    // Per slot results of the simulation pass, drawn or retired afterwards on the main thread
+    struct ParticleDraw
+    {
+        bool drawn;
+        float scale;
+        int r, g, b, a;
+    };
+    std::vector<ParticleDraw> draws;
+    void Simulate(int begin, int end);
+
     std::queue<int> free_list;
 };
 
@@ -0,0 +1,171 @@
+#include "Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#ifdef ENGINE_PROFILER
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char* name = nullptr;
+        int64_t start_us = 0;
+        int64_t duration_us = 0;
+        uint32_t thread_id = 0;
+
+        // Counters are drawn as a graph, duration_us holds their value
+        bool counter = false;
+
+        // Index + 1 of the write that last completed into this slot
+        std::atomic<uint64_t> sequence{ 0 };
+    };
+
+    // Ring buffer, the oldest events are overwritten once it wraps
+    const uint64_t TRACE_CAPACITY = 1 << 16;
+    TraceEvent trace_events[TRACE_CAPACITY];
+    std::atomic<uint64_t> trace_write_index{ 0 };
+    std::atomic<uint32_t> next_thread_id{ 1 };
+}
+
+// Read ENGINE_TRACE, the path a trace is written to when the program exits
+void Profiler::Init()
+{
+    const char* path = std::getenv("ENGINE_TRACE");
+    if (!path || exit_trace_path == path)
+        return;
+
+    if (exit_trace_path.empty())
+        std::atexit(&DumpOnExit);
+    exit_trace_path = path;
+}
+
+// Claim a slot with one atomic increment, publish it with its sequence number
+void Profiler::Record(const char* name, int64_t start_us, int64_t end_us)
+{
+    uint64_t index = trace_write_index.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent& e = trace_events[index & (TRACE_CAPACITY - 1)];
+
+    e.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    e.name = name;
+    e.start_us = start_us;
+    e.duration_us = end_us - start_us;
+    e.thread_id = GetThreadID();
+    e.counter = false;
+
+    e.sequence.store(index + 1, std::memory_order_release);
+}
+
+// A sample of a value over time, like the Lua heap size
+void Profiler::RecordCounter(const char* name, int64_t value)
+{
+    uint64_t index = trace_write_index.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent& e = trace_events[index & (TRACE_CAPACITY - 1)];
+
+    e.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    e.name = name;
+    e.start_us = Now();
+    e.duration_us = value;
+    e.thread_id = GetThreadID();
+    e.counter = true;
+
+    e.sequence.store(index + 1, std::memory_order_release);
+}
+
+// Write every complete event still in the ring as Chrome trace_event JSON
+bool Profiler::DumpTrace(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "error: failed to open trace file " << path << std::endl;
+        return false;
+    }
+
+    uint64_t end = trace_write_index.load(std::memory_order_acquire);
+    uint64_t begin = end > TRACE_CAPACITY ? end - TRACE_CAPACITY : 0;
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (uint64_t i = begin; i < end; i++)
+    {
+        TraceEvent& e = trace_events[i & (TRACE_CAPACITY - 1)];
+        if (e.sequence.load(std::memory_order_acquire) != i + 1)
+            continue;
+
+        const char* name = e.name;
+        int64_t start_us = e.start_us;
+        int64_t duration_us = e.duration_us;
+        uint32_t thread_id = e.thread_id;
+        bool counter = e.counter;
+
+        // Skip slots that were overwritten while we copied them
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (e.sequence.load(std::memory_order_relaxed) != i + 1)
+            continue;
+
+        if (!first)
+            file << ",";
+        first = false;
+
+        if (counter)
+        {
+            file << "\n{\"name\":\"" << name << "\",\"cat\":\"engine\",\"ph\":\"C\",\"pid\":1,\"tid\":" << thread_id
+                << ",\"ts\":" << start_us << ",\"args\":{\"value\":" << duration_us << "}}";
+            continue;
+        }
+
+        file << "\n{\"name\":\"" << name << "\",\"cat\":\"engine\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread_id
+            << ",\"ts\":" << start_us << ",\"dur\":" << duration_us << "}";
+    }
+    file << "\n]}\n";
+    return true;
+}
+
+// Microseconds on the steady clock
+int64_t Profiler::Now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::DumpOnExit()
+{
+    DumpTrace(exit_trace_path);
+}
+
+// Small sequential ids read better in the trace viewer than hashed thread ids
+uint32_t Profiler::GetThreadID()
+{
+    thread_local uint32_t thread_id = next_thread_id.fetch_add(1, std::memory_order_relaxed);
+    return thread_id;
+}
+
+#else
+
+void Profiler::Init() { }
+
+void Profiler::Record(const char*, int64_t, int64_t) { }
+
+void Profiler::RecordCounter(const char*, int64_t) { }
+
+bool Profiler::DumpTrace(const std::string&)
+{
+    std::cout << "error: profiler disabled, build with ENGINE_PROFILER to record traces" << std::endl;
+    return false;
+}
+
+int64_t Profiler::Now() { return 0; }
+
+void Profiler::DumpOnExit() { }
+
+uint32_t Profiler::GetThreadID() { return 0; }
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <string>
+
+// Frame profiler. Build with -DENGINE_PROFILER to compile the zones in,
+// otherwise PROFILE_ZONE expands to nothing and DumpTrace reports that it is disabled.
+class Profiler
+{
+public:
+    static void Init();
+
+    static void Record(const char* name, int64_t start_us, int64_t end_us);
+    static void RecordCounter(const char* name, int64_t value);
+    static bool DumpTrace(const std::string& path);
+
+    static int64_t Now();
+
+private:
+    static inline std::string exit_trace_path;
+    static void DumpOnExit();
+
+    static uint32_t GetThreadID();
+};
+
+// Records the lifetime of the enclosing scope under name
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* zone_name) : name(zone_name), start_us(Profiler::Now()) { }
+    ~ProfileZone() { Profiler::Record(name, start_us, Profiler::Now()); }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    int64_t start_us;
+};
+
+#ifdef ENGINE_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) Profiler::RecordCounter(name, value)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_COUNTER(name, value)
+#endif
+
+#endif
@@ -8,7 +8,7 @@ float RaycastCallback::ReportFixture(b2Fixture* fixture, const b2Vec2& contact_p
     if (!actor)
         return -1.0f;
     
-    hitresult.actor = actor;
+    hitresult.actor = actor->GetHandle();
     hitresult.point = contact_point;
     hitresult.normal = contact_normal;
     hitresult.is_trigger = fixture->IsSensor();
@@ -24,7 +24,7 @@ float RaycastCallbackAll::ReportFixture(b2Fixture* fixture, const b2Vec2& contac
         return -1.0f;
 
     HitResult& hitresult = hitresult_list.emplace_back();
-    hitresult.actor = actor;
+    hitresult.actor = actor->GetHandle();
     hitresult.point = contact_point;
     hitresult.normal = contact_normal;
     hitresult.is_trigger = fixture->IsSensor();
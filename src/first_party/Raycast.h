@@ -2,6 +2,7 @@
 #define RAYCAST_H
 
 #include "Actor.h"
+#include "ActorHandle.h"
 
 #include "box2d/box2d.h"
 
@@ -10,7 +11,7 @@ class Actor;
 class HitResult
 {
 public:
-    Actor* actor = nullptr;
+    ActorHandle actor;
     b2Vec2 point;
     b2Vec2 normal;
     bool is_trigger = false;
@@ -1,7 +1,10 @@
 #include "Renderer.h"
 
+#include "Engine.h"
 #include "EngineUtils.h"
 #include "ImageDB.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 #include "TextDB.h"
 #include "EditorManager.h"
 
@@ -36,6 +39,20 @@ void Renderer::RenderClear()
 
 void Renderer::Present()
 {
+    PROFILE_ZONE("Renderer::Present");
+
+    // Sorting and culling run as one graph on the job system, the SDL calls after it stay serial
+    static TaskGraph prepare_graph;
+    prepare_graph.Clear();
+    int sort_images = prepare_graph.Add([]() {
+        std::stable_sort(image_draw_request_queue.begin(), image_draw_request_queue.end(), CompareImageRequests());
+    });
+    prepare_graph.Add(&TransformImageDrawRequests, { sort_images });
+    prepare_graph.Add([]() {
+        std::stable_sort(ui_draw_request_queue.begin(), ui_draw_request_queue.end(), CompareUIRequests());
+    });
+    prepare_graph.Run();
+
     RenderAndClearImageDrawRequests();
     RenderAndClearUIDrawRequests();
     RenderAndClearTextDrawRequests();
@@ -45,6 +62,7 @@ void Renderer::Present()
     ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), Renderer::GetRenderer());
 #endif
 
+    PROFILE_ZONE("Renderer::RenderPresent");
     Helper::SDL_RenderPresent(renderer);
 }
 
@@ -77,12 +95,18 @@ Renderer::ImageDrawRequest& Renderer::CreateImageRequest(const std::string& imag
 
 void Renderer::Draw(const std::string& image_name, float x, float y)
 {
+    if (Engine::headless || IsCulled())
+        return;
+
     CreateImageRequest(image_name, x, y);
 }
 
 void Renderer::DrawEx(const std::string& image_name, float x, float y, float rotation_degrees,
     float scale_x, float scale_y, float pivot_x, float pivot_y, float r, float g, float b, float a, float sorting_order)
 {
+    if (Engine::headless || IsCulled())
+        return;
+
     DrawImage(image_name, x, y, rotation_degrees, scale_x, scale_y, pivot_x, pivot_y,
         static_cast<int>(r), static_cast<int>(g), static_cast<int>(b), static_cast<int>(a), static_cast<int>(sorting_order));
 }
@@ -90,6 +114,9 @@ void Renderer::DrawEx(const std::string& image_name, float x, float y, float rot
 void Renderer::DrawImage(const std::string& image_name, float x, float y, float rotation_degrees,
     float scale_x, float scale_y, float pivot_x, float pivot_y, int r, int g, int b, int a, int sorting_order)
 {
+    if (Engine::headless || IsCulled())
+        return;
+
     ImageDrawRequest& request = CreateImageRequest(image_name, x, y);
 
     request.rotation = static_cast<int>(rotation_degrees);
@@ -104,22 +131,38 @@ void Renderer::DrawImage(const std::string& image_name, float x, float y, float
     request.sorting_order = sorting_order;
 }
 
+// Move sorted requests to screen space and cull them, split further across the job system
+void Renderer::TransformImageDrawRequests()
+{
+    PROFILE_ZONE("Renderer::TransformImageDrawRequests");
+
+    JobSystem::ParallelFor(image_draw_request_queue.size(), 1024, [](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            ImageDrawRequest& request = image_draw_request_queue[i];
+            request.rect.w *= glm::abs(request.scale_x);
+            request.rect.h *= glm::abs(request.scale_y);
+
+            request.pivot_point = { request.pivot_x * request.rect.w, request.pivot_y * request.rect.h };
+
+            request.rect.x = (request.rect.x - camera_position.x) * PIXELS_PER_METER + window_center.x - request.pivot_point.x;
+            request.rect.y = (request.rect.y - camera_position.y) * PIXELS_PER_METER + window_center.y - request.pivot_point.y;
+
+            request.visible = !(request.rect.x + request.rect.w < -50.0f || request.rect.y + request.rect.h < -50.0f || request.rect.x > window_box.x || request.rect.y > window_box.y);
+        }
+    });
+}
+
+// Draw the requests Present has sorted and transformed
 void Renderer::RenderAndClearImageDrawRequests()
 {
-    std::stable_sort(image_draw_request_queue.begin(), image_draw_request_queue.end(), CompareImageRequests());
+    PROFILE_ZONE("Renderer::RenderAndClearImageDrawRequests");
+
     SDL_RenderSetScale(renderer, zoom_factor, zoom_factor);
 
     for (auto& request : image_draw_request_queue)
     {
-        request.rect.w *= glm::abs(request.scale_x);
-        request.rect.h *= glm::abs(request.scale_y);
-
-        SDL_FPoint pivot_point = { request.pivot_x * request.rect.w, request.pivot_y * request.rect.h };
-
-        request.rect.x = (request.rect.x - camera_position.x) * PIXELS_PER_METER + window_center.x - pivot_point.x;
-        request.rect.y = (request.rect.y - camera_position.y) * PIXELS_PER_METER + window_center.y - pivot_point.y;
-
-        if (request.rect.x + request.rect.w < -50.0f || request.rect.y + request.rect.h < -50.0f || request.rect.x > window_box.x || request.rect.y > window_box.y)
+        if (!request.visible)
             continue;
 
         int flip_mode = SDL_FLIP_NONE;
@@ -139,7 +182,7 @@ void Renderer::RenderAndClearImageDrawRequests()
             NULL,
             &request.rect,
             static_cast<float>(request.rotation),
-            &pivot_point,
+            &request.pivot_point,
             static_cast<SDL_RendererFlip>(flip_mode)
         );
 
@@ -171,11 +214,17 @@ Renderer::UIDrawRequest& Renderer::CreateUIRequest(const std::string& image_name
 
 void Renderer::DrawUI(const std::string& image_name, float x, float y)
 {
+    if (Engine::headless)
+        return;
+
     CreateUIRequest(image_name, static_cast<int>(x), static_cast<int>(y));
 }
 
 void Renderer::DrawUIEx(const std::string& image_name, float x, float y, float r, float g, float b, float a, float sorting_order)
 {
+    if (Engine::headless)
+        return;
+
     UIDrawRequest& request = CreateUIRequest(image_name, static_cast<int>(x), static_cast<int>(y));
     request.r = static_cast<int>(r);
     request.g = static_cast<int>(g);
@@ -186,7 +235,7 @@ void Renderer::DrawUIEx(const std::string& image_name, float x, float y, float r
 
 void Renderer::RenderAndClearUIDrawRequests()
 {
-    std::stable_sort(ui_draw_request_queue.begin(), ui_draw_request_queue.end(), CompareUIRequests());
+    PROFILE_ZONE("Renderer::RenderAndClearUIDrawRequests");
 
     for (auto& request : ui_draw_request_queue)
     {
@@ -207,6 +256,9 @@ void Renderer::RenderAndClearUIDrawRequests()
 
 void Renderer::DrawText(const std::string& text_content, float x, float y, const std::string& font_name, float font_size, float r, float g, float b, float a)
 {
+    if (Engine::headless)
+        return;
+
     int _x = static_cast<int>(x), _y = static_cast<int>(y);
     int _r = static_cast<int>(r), _g = static_cast<int>(g), _b = static_cast<int>(b), _a = static_cast<int>(a);
     TextDrawRequest& request = text_draw_request_queue.emplace_back();
@@ -236,6 +288,8 @@ void Renderer::DrawText(const std::string& text_content, float x, float y, const
 
 void Renderer::RenderAndClearTextDrawRequests()
 {
+    PROFILE_ZONE("Renderer::RenderAndClearTextDrawRequests");
+
     for (auto& request : text_draw_request_queue)
     {
         Helper::SDL_RenderCopy(renderer, request.texture, nullptr, &request.rect);
@@ -251,6 +305,9 @@ void Renderer::RenderAndClearTextDrawRequests()
 
 void Renderer::DrawPixel(float x, float y, float r, float g, float b, float a)
 {
+    if (Engine::headless || IsCulled())
+        return;
+
     PixelDrawRequest& request = pixel_draw_request_queue.emplace_back();
     request.x = static_cast<int>(x);
     request.y = static_cast<int>(y);
@@ -262,6 +319,8 @@ void Renderer::DrawPixel(float x, float y, float r, float g, float b, float a)
 
 void Renderer::RenderAndClearPixelDrawRequests()
 {
+    PROFILE_ZONE("Renderer::RenderAndClearPixelDrawRequests");
+
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
 
     for (auto& request: pixel_draw_request_queue)
@@ -26,6 +26,10 @@ private:
         int b = 255;
         int a = 255;
         int sorting_order = 0;
+
+        // Filled in by the transform pass before drawing
+        SDL_FPoint pivot_point = { 0.0f, 0.0f };
+        bool visible = false;
     };
     struct CompareImageRequests {
         bool operator()(const ImageDrawRequest& lhs, const ImageDrawRequest& rhs) const {
@@ -77,6 +81,13 @@ public:
     static void SetZoom(float zoom);
     static float GetZoom() { return zoom_factor; }
 
+    // World-space draws made while an actor on a culled layer runs are dropped
+    static void SetCullingMask(uint32_t layer_mask) { culling_mask = layer_mask; }
+    static uint32_t GetCullingMask() { return culling_mask; }
+    static void SetDrawingLayer(int layer) { drawing_layer_mask = 1u << layer; }
+    static void ClearDrawingLayer() { drawing_layer_mask = ~0u; }
+    static bool IsCulled() { return (drawing_layer_mask & culling_mask) == 0; }
+
     // Image Drawing
     static ImageDrawRequest & CreateImageRequest(const std::string& image_name, float x, float y);
     static void Draw(const std::string& image_name, float x, float y);
@@ -109,6 +120,9 @@ private:
     static inline glm::vec2 window_center = glm::vec2(320.f, 180.0f);
 
     static inline float zoom_factor = 1.0f;
+
+    static inline uint32_t culling_mask = ~0u;
+    static inline uint32_t drawing_layer_mask = ~0u;
     static inline float inverse_zoom = 1.0f;
     static inline glm::vec2 window_box = glm::vec2(800.0f, 450.0f);
 
@@ -117,6 +131,7 @@ private:
     static inline int clear_color_g = 255;
     static inline int clear_color_b = 255;
 
+    static void TransformImageDrawRequests();
     static void RenderAndClearImageDrawRequests();
     static void RenderAndClearUIDrawRequests();
     static void RenderAndClearTextDrawRequests();
@@ -1,13 +1,33 @@
 #include "Rigidbody.h"
 
+#include "ActorPool.h"
+#include "Profiler.h"
+#include "ScriptMemory.h"
+#include "TagDB.h"
+#include "Timestep.h"
+
 #include "glm/glm.hpp"
 
 
-// Update physics world
+// Remember each body's transform, then advance the physics world one fixed step
 void Rigidbody::PhysicsStep()
 {
-    if (world)
-        world->Step(1.0f / 60.0f, 8, 3);
+    PROFILE_ZONE("Rigidbody::PhysicsStep");
+
+    if (!world)
+        return;
+
+    for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+    {
+        Rigidbody* rb = reinterpret_cast<Rigidbody*>(b->GetUserData().pointer);
+        if (!rb)
+            continue;
+
+        rb->previous_position = b->GetPosition();
+        rb->previous_angle = b->GetAngle();
+    }
+
+    world->Step(Timestep::GetFixedDeltaTime(), 8, 3);
 }
 
 // Initialize Rigidbody after reading in values
@@ -17,6 +37,7 @@ void Rigidbody::OnStart()
     {
         world = new b2World(b2Vec2(0.0f, 9.8f));
         world->SetContactListener(&detector);
+        world->SetContactFilter(&filter);
     }
 
     CreateBody();
@@ -45,8 +66,12 @@ void Rigidbody::CreateBody()
     body_def.bullet = precise;
     body_def.angularDamping = angular_friction;
     body_def.gravityScale = gravity_scale;
+    body_def.userData.pointer = reinterpret_cast<uintptr_t>(this);
 
     body = world->CreateBody(&body_def);
+
+    previous_position = body_def.position;
+    previous_angle = body_def.angle;
 }
 
 // Create collider fixture type and add to body
@@ -72,11 +97,9 @@ void Rigidbody::CreateColliderFixture()
     fixture_def.density = density;
     fixture_def.restitution = bounciness;
     fixture_def.friction = friction;
-    fixture_def.userData.pointer = reinterpret_cast<uintptr_t>(actor);
+    fixture_def.userData.pointer = reinterpret_cast<uintptr_t>(ActorPool::Resolve(actor));
 
-    fixture_def.filter.groupIndex = 1;
-    fixture_def.filter.categoryBits = 0x0001;
-    fixture_def.filter.maskBits = 0x0001;
+    fixture_def.filter = GetLayerFilter();
 
     fixture_def.isSensor = false;
     body->CreateFixture(&fixture_def);
@@ -103,11 +126,9 @@ void Rigidbody::CreateTriggerFixture()
     b2FixtureDef fixture_def;
     fixture_def.shape = shape;
     fixture_def.density = density;
-    fixture_def.userData.pointer = reinterpret_cast<uintptr_t>(actor);
+    fixture_def.userData.pointer = reinterpret_cast<uintptr_t>(ActorPool::Resolve(actor));
 
-    fixture_def.filter.groupIndex = 2;
-    fixture_def.filter.categoryBits = 0x0002;
-    fixture_def.filter.maskBits = 0x0002;
+    fixture_def.filter = GetLayerFilter();
 
     fixture_def.isSensor = true;
     body->CreateFixture(&fixture_def);
@@ -123,18 +144,70 @@ void Rigidbody::CreateDefaultFixture()
     fixture_def.shape = &phantom_shape;
     fixture_def.density = density;
 
+    // Touches nothing, and keeps out of layer changes
     fixture_def.filter.groupIndex = -1;
+    fixture_def.filter.categoryBits = 0;
 
     fixture_def.isSensor = true;
     body->CreateFixture(&fixture_def);
 }
 
+// Collision category and mask for the owning actor's layer
+b2Filter Rigidbody::GetLayerFilter() const
+{
+    Actor* owner = ActorPool::Resolve(actor);
+    int layer = owner ? owner->GetLayer() : 0;
+
+    b2Filter filter;
+    filter.categoryBits = static_cast<uint16_t>(1u << layer);
+    filter.maskBits = TagDB::GetCollisionMask(layer);
+    return filter;
+}
+
+// Refilter the collider and trigger after the owning actor moved to another layer
+void Rigidbody::RefreshLayer()
+{
+    if (!body)
+        return;
+
+    b2Filter filter = GetLayerFilter();
+    for (b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext())
+        if (f->GetFilterData().groupIndex >= 0)
+            f->SetFilterData(filter);
+}
+
 // On destruction, remove body from world
 void Rigidbody::OnDestroy()
 {
     world->DestroyBody(body);
 }
 
+// Park the body of a pooled actor, put it back where the template placed it and take it out of the simulation
+void Rigidbody::OnRelease()
+{
+    if (!body)
+        return;
+
+    body->SetTransform(b2Vec2(x, y), rotation * TO_RADIANS);
+    body->SetLinearVelocity(b2Vec2(0.0f, 0.0f));
+    body->SetAngularVelocity(0.0f);
+    body->SetAwake(false);
+    body->SetEnabled(false);
+
+    previous_position = body->GetPosition();
+    previous_angle = body->GetAngle();
+}
+
+// Return a parked body to the simulation
+void Rigidbody::OnReuse()
+{
+    if (!body)
+        return;
+
+    body->SetEnabled(true);
+    body->SetAwake(true);
+}
+
 // If body has not been initialized, overwrite initial values
 void Rigidbody::SetPosition(b2Vec2 vec2)
 {
@@ -144,7 +217,10 @@ void Rigidbody::SetPosition(b2Vec2 vec2)
         y = vec2.y;
     }
     else
+    {
         body->SetTransform(vec2, body->GetAngle());
+        previous_position = vec2;
+    }
 }
 
 // If body has not been initialized, return initial values
@@ -155,13 +231,30 @@ b2Vec2 Rigidbody::GetPosition() const
     return body->GetPosition();
 }
 
+// Position blended between the last two physics steps by the leftover frame time
+b2Vec2 Rigidbody::GetInterpolatedPosition() const
+{
+    if (!body)
+        return b2Vec2(x, y);
+
+    float alpha = Timestep::GetInterpolationAlpha();
+    const b2Vec2& current = body->GetPosition();
+    return b2Vec2(
+        previous_position.x + (current.x - previous_position.x) * alpha,
+        previous_position.y + (current.y - previous_position.y) * alpha
+    );
+}
+
 // If body has not been initialized, overwrite initial values
 void Rigidbody::SetRotation(float degrees_clockwise)
 {
     if (!body)
         rotation = degrees_clockwise;
     else
+    {
         body->SetTransform(body->GetPosition(), degrees_clockwise * TO_RADIANS);
+        previous_angle = body->GetAngle();
+    }
 }
 
 // If body has not been initialized, return initial values
@@ -173,6 +266,16 @@ float Rigidbody::GetRotation() const
         return body->GetAngle() * TO_DEGREES;
 }
 
+// Rotation blended between the last two physics steps by the leftover frame time
+float Rigidbody::GetInterpolatedRotation() const
+{
+    if (!body)
+        return rotation;
+
+    float alpha = Timestep::GetInterpolationAlpha();
+    return glm::mix(previous_angle, body->GetAngle(), alpha) * TO_DEGREES;
+}
+
 // If body has not been initialized, overwrite initial values
 void Rigidbody::SetGravityScale(float gravity)
 {
@@ -243,6 +346,8 @@ luabridge::LuaRef Rigidbody::Raycast(b2Vec2 pos, b2Vec2 dir, float dist)
 
 luabridge::LuaRef Rigidbody::RaycastAll(b2Vec2 pos, b2Vec2 dir, float dist)
 {
+    ScriptMemory::Scope memory_scope(MEMORY_RESULTS);
+
     if (!world || dist == 0)
         return luabridge::LuaRef(lua_state);
 
@@ -14,14 +14,19 @@ class Rigidbody
 public:
     void OnStart();
     void OnDestroy();
+    void OnRelease();
+    void OnReuse();
+
+    void RefreshLayer();
 
     std::string type = "Rigidbody";
     std::string key = "???";
-    Actor* actor = nullptr;
+    ActorHandle actor;
     bool enabled = true;
 
     static inline b2World* world = nullptr;
     static inline CollisionDetector detector;
+    static inline CollisionFilter filter;
     static void PhysicsStep();
 
     static luabridge::LuaRef Raycast(b2Vec2 pos, b2Vec2 dir, float dist);
@@ -57,9 +62,11 @@ public:
 
     void SetPosition(b2Vec2 vec2);
     b2Vec2 GetPosition() const;
+    b2Vec2 GetInterpolatedPosition() const;
 
     void SetRotation(float degrees_clockwise);
     float GetRotation() const;
+    float GetInterpolatedRotation() const;
 
     void SetGravityScale(float gravity);
     float GetGravityScale() const;
@@ -77,6 +84,11 @@ public:
 
 private:
     void CreateBody();
+    b2Filter GetLayerFilter() const;
+
+    // Transform before the most recent physics step, for render interpolation
+    b2Vec2 previous_position = b2Vec2(0.0f, 0.0f);
+    float previous_angle = 0.0f;
     
     void CreateColliderFixture();
     void CreateTriggerFixture();
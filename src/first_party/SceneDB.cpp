@@ -1,8 +1,30 @@
 #include "SceneDB.h"
 
+#include "ActorPool.h"
+#include "CoroutineScheduler.h"
 #include "EngineUtils.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "ScriptMemory.h"
+#include "ScriptShards.h"
 #include "TemplateDB.h"
 
+#include "box2d/box2d.h"
+
+#include <algorithm>
+
+
+// Read the spatial grid's cell size from game.config
+void SceneDB::Init(const rapidjson::Document& doc)
+{
+    float spatial_cell_size = 4.0f;
+    EngineUtils::GetConfigValue(doc, "spatial_cell_size", spatial_cell_size);
+
+    if (spatial_cell_size <= 0.0f)
+        spatial_cell_size = 4.0f;
+
+    spatial_grid.SetCellSize(spatial_cell_size);
+}
 
 // Load all actors in scene
 void SceneDB::LoadScene(const std::string scene_name)
@@ -25,7 +47,7 @@ void SceneDB::UnloadScene()
     retained_actors.clear();
     retained_actors.reserve(loaded_actors.size());
 
-    name_to_actor.clear();
+    ClearActorIndex();
     next_scene.clear();
 
 
@@ -36,18 +58,66 @@ void SceneDB::UnloadScene()
         if (a->retain)
         {
             retained_actors.push_back(a);
-            name_to_actor[a->actor_name].insert(a);
+            IndexActor(a);
         }
         else
             a->Destroy();
     }
 
+    // Actors that died while in the scene go with it, ones that never entered it are reclaimed as usual
+    auto dropped = [](const Actor* a) { return !a->alive && a->scene_index >= 0; };
+    dying_actors.erase(std::remove_if(dying_actors.begin(), dying_actors.end(), dropped), dying_actors.end());
+    for (std::vector<Actor*>* queue : { &actors_adding_components, &actors_removing_components })
+        queue->erase(std::remove_if(queue->begin(), queue->end(), dropped), queue->end());
+
+    // Every OnDestroy has run, so no script can reach the dropped actors anymore
+    for (Actor* a : loaded_actors)
+    {
+        if (a->alive)
+            continue;
+
+        if (a->releasing)
+        {
+            a->scene_index = -1;
+            a->queued_added_components = false;
+            a->queued_removed_components = false;
+            Park(a);
+        }
+        else
+        {
+            CoroutineScheduler::StopOwned(a->GetHandle());
+            ActorPool::Release(a);
+        }
+    }
+
     loaded_actors = std::move(retained_actors);
+    for (size_t i = 0; i < loaded_actors.size(); i++)
+        loaded_actors[i]->scene_index = static_cast<int>(i);
 }
 
+// Drop the scene without running OnDestroy, the Lua state may already have been replaced.
+// The actors are not released because Rigidbody bodies left in the world still point at them
 void SceneDB::RestartScene()
 {
     loaded_actors.clear();
+    ClearActorIndex();
+    parked_actors.clear();
+    dying_actors.clear();
+    dead_actors.clear();
+    actors_adding_components.clear();
+    actors_removing_components.clear();
+    update_hooks.Clear();
+    late_update_hooks.Clear();
+    fixed_update_hooks.Clear();
+    ScriptShards::Clear();
+    update_lod.Clear();
+    has_update_focus = false;
+    component_index.Clear();
+    type_query_results.clear();
+    name_query_results.clear();
+    spatial_query_results.clear();
+    handle_userdata.reset();
+    CoroutineScheduler::Clear();
 }
 
 // Populate loaded_actor vector
@@ -60,67 +130,350 @@ void SceneDB::LoadActors(const std::string& path)
     // foreach actor a in actors, set values and emplace back
     for (const rapidjson::Value& a : actors.GetArray())
     {
-        Actor* new_actor = new_actors_to_add.emplace_back(new Actor(a));
-        name_to_actor[new_actor->actor_name].insert(new_actor);
+        Actor* new_actor = new_actors_to_add.emplace_back(ActorPool::Create(a));
+        IndexActor(new_actor);
     }
 }
 
 // Call lifetime functions on all actors
 void SceneDB::UpdateActors()
 {
-    std::vector<Actor*> alive_actors;
-    alive_actors.reserve(loaded_actors.size() + actors_to_add.size());
+    PROFILE_ZONE("SceneDB::UpdateActors");
 
-    // Add alive actors to vector
-    for (Actor* a : loaded_actors)
-        if (a->alive)
-            alive_actors.push_back(a);
+    // Actors destroyed since the last update leave the scene now and are reclaimed at the end of this one
+    std::swap(dead_actors, dying_actors);
+    for (Actor* a : dead_actors)
+        RemoveFromScene(a);
 
     actors_to_add.clear();
     std::swap(actors_to_add, new_actors_to_add);
-    // Add new actors into alive actors
-    for (Actor* a : actors_to_add)
-        if (a->alive)
+    // Start new actors and add them to the scene
+    {
+        PROFILE_ZONE("SceneDB::Start");
+        for (Actor* a : actors_to_add)
         {
+            if (!a->alive)
+                continue;
+
             a->Start();
-            alive_actors.push_back(a);
+            AddToScene(a);
+            if (a->alive)
+                RegisterActor(a);
         }
+        actors_to_add.clear();
+    }
 
-    // Add new components on alive actors
-    for (Actor* a : alive_actors)
-        if (a->alive)
-            a->ProcessAddedComponents();
+    // Add new components on actors that queued some, ones queued from here on wait for the next frame
+    {
+        PROFILE_ZONE("SceneDB::ProcessAddedComponents");
+        static std::vector<Actor*> queued;
+        queued.clear();
+        std::swap(queued, actors_adding_components);
+
+        for (Actor* a : queued)
+        {
+            // Actors that have not started yet keep their queue until they have
+            if (a->alive && a->scene_index < 0)
+            {
+                actors_adding_components.push_back(a);
+                continue;
+            }
+
+            a->queued_added_components = false;
+            if (a->alive)
+                a->ProcessAddedComponents();
+        }
+    }
+
+    // Positions set since the last update become visible to spatial queries
+    {
+        PROFILE_ZONE("SceneDB::RebuildSpatialGrid");
+        spatial_grid.Rebuild();
+    }
 
 #ifndef NDEBUG
     if (stopped)
     {
+        PROFILE_ZONE("SceneDB::EditorUpdate");
+
         // Update function on alive actors
-        for (Actor* a : alive_actors)
+        for (Actor* a : loaded_actors)
             if (a->alive)
                 a->EditorUpdate();
     }
     else
 #endif
     {
-        // Update function on alive actors
-        for (Actor* a : alive_actors)
-            if (a->alive)
-                a->Update();
+        // Move components between their near and far update rates
+        {
+            PROFILE_ZONE("SceneDB::UpdateLOD");
+            update_lod.Refresh(spatial_grid, GetUpdateFocus(), update_hooks, late_update_hooks);
+        }
 
-        // Late Update function on alive actors
-        for (Actor* a : alive_actors)
-            if (a->alive)
-                a->LateUpdate();
+        // Update function on components that have one
+        {
+            PROFILE_ZONE("SceneDB::Update");
+            update_hooks.Run();
+        }
+
+        // Update function on components of parallel types, every shard at once
+        {
+            PROFILE_ZONE("SceneDB::ParallelUpdate");
+            ScriptShards::Run(HOOK_UPDATE);
+        }
+
+        // Late Update function on components that have one
+        {
+            PROFILE_ZONE("SceneDB::LateUpdate");
+            late_update_hooks.Run();
+        }
+
+        // Late Update function on components of parallel types
+        {
+            PROFILE_ZONE("SceneDB::ParallelLateUpdate");
+            ScriptShards::Run(HOOK_LATE_UPDATE);
+        }
+
+        // Coroutines that are due this frame
+        {
+            PROFILE_ZONE("SceneDB::Coroutines");
+            CoroutineScheduler::Update();
+        }
     }
 
 
-    // Add new components on alive actors
-    for (Actor* a : alive_actors)
-        if (a->alive)
-            a->ProcessRemovedComponents();
+    // Drop removed components on actors that queued some
+    {
+        PROFILE_ZONE("SceneDB::ProcessRemovedComponents");
+        static std::vector<Actor*> queued;
+        queued.clear();
+        std::swap(queued, actors_removing_components);
+
+        for (Actor* a : queued)
+        {
+            if (a->alive && a->scene_index < 0)
+            {
+                actors_removing_components.push_back(a);
+                continue;
+            }
+
+            a->queued_removed_components = false;
+            if (a->alive)
+                a->ProcessRemovedComponents();
+        }
+    }
 
     // Clean all previously killed actors
-    loaded_actors = std::move(alive_actors);
+    for (Actor* a : dead_actors)
+    {
+        if (a->releasing)
+            Park(a);
+        else
+            Reclaim(a);
+    }
+    dead_actors.clear();
+
+    component_index.Compact();
+}
+
+// Call fixed-rate lifetime function on all actors, once per simulation step
+void SceneDB::FixedUpdateActors()
+{
+    PROFILE_ZONE("SceneDB::FixedUpdateActors");
+
+#ifndef NDEBUG
+    if (stopped)
+        return;
+#endif
+
+    fixed_update_hooks.Run();
+}
+
+// Make an actor findable by name, tag and layer
+void SceneDB::IndexActor(Actor* actor)
+{
+    name_to_actor[actor->actor_name].insert(actor);
+
+    if (actor->layer_slot != -1)
+        return;
+
+    for (int tag = 0; tag < TagDB::MAX_TAGS; tag++)
+    {
+        if (!(actor->tags & (1u << tag)))
+            continue;
+
+        actor->tag_slots[tag] = static_cast<int>(tagged_actors[tag].size());
+        tagged_actors[tag].push_back(actor);
+    }
+
+    actor->layer_slot = static_cast<int>(layer_actors[actor->layer].size());
+    layer_actors[actor->layer].push_back(actor);
+}
+
+// Remove an actor from the name, tag and layer lookups, the tag and layer lists swap-remove.
+// Actors leaving the scene also leave the spatial grid, SetTags and SetLayer keep them there
+void SceneDB::UnindexActor(Actor* actor)
+{
+    auto it = name_to_actor.find(actor->actor_name);
+    if (it != name_to_actor.end())
+        it->second.erase(actor);
+
+    if (actor->layer_slot == -1)
+        return;
+
+    for (int tag = 0; tag < TagDB::MAX_TAGS; tag++)
+    {
+        if (!(actor->tags & (1u << tag)))
+            continue;
+
+        std::vector<Actor*>& list = tagged_actors[tag];
+        Actor* last = list.back();
+        list[actor->tag_slots[tag]] = last;
+        last->tag_slots[tag] = actor->tag_slots[tag];
+        list.pop_back();
+    }
+
+    std::vector<Actor*>& list = layer_actors[actor->layer];
+    Actor* last = list.back();
+    list[actor->layer_slot] = last;
+    last->layer_slot = actor->layer_slot;
+    list.pop_back();
+
+    actor->layer_slot = -1;
+}
+
+// Empty every lookup, listed actors are marked as unlisted
+void SceneDB::ClearActorIndex()
+{
+    name_to_actor.clear();
+    spatial_grid.Clear();
+
+    for (std::vector<Actor*>& list : layer_actors)
+    {
+        for (Actor* a : list)
+            a->layer_slot = -1;
+        list.clear();
+    }
+
+    for (std::vector<Actor*>& list : tagged_actors)
+        list.clear();
+}
+
+// Append an actor to the scene list
+void SceneDB::AddToScene(Actor* actor)
+{
+    actor->scene_index = static_cast<int>(loaded_actors.size());
+    loaded_actors.push_back(actor);
+}
+
+// Take an actor out of the scene list by moving the last actor into its place
+void SceneDB::RemoveFromScene(Actor* actor)
+{
+    if (actor->scene_index < 0)
+        return;
+
+    Actor* last = loaded_actors.back();
+    loaded_actors[actor->scene_index] = last;
+    last->scene_index = actor->scene_index;
+    loaded_actors.pop_back();
+
+    actor->scene_index = -1;
+}
+
+// Remember that an actor has components to add, once per frame
+void SceneDB::QueueAddedComponents(Actor* actor)
+{
+    if (actor->queued_added_components)
+        return;
+
+    actor->queued_added_components = true;
+    actors_adding_components.push_back(actor);
+}
+
+// Remember that an actor has components to remove, once per frame
+void SceneDB::QueueRemovedComponents(Actor* actor)
+{
+    if (actor->queued_removed_components)
+        return;
+
+    actor->queued_removed_components = true;
+    actors_removing_components.push_back(actor);
+}
+
+// Add all live components of an actor entering the scene to the hook lists
+void SceneDB::RegisterActor(Actor* actor)
+{
+    for (Component& component : actor->components)
+        if (component.alive)
+            RegisterComponent(actor, &component);
+    actor->RefreshHookMask();
+}
+
+void SceneDB::RegisterComponent(Actor* actor, Component* component)
+{
+    component_index.Add(actor, component);
+    if (component->IsParallel())
+    {
+        ScriptShards::Add(actor, component);
+    }
+    else
+    {
+        if (component->HasHook(HOOK_UPDATE))
+            update_hooks.Add(actor, component, component->hooks->update_interval);
+        if (component->HasHook(HOOK_LATE_UPDATE))
+            late_update_hooks.Add(actor, component, component->hooks->late_update_interval);
+    }
+    if (component->HasHook(HOOK_FIXED_UPDATE))
+        fixed_update_hooks.Add(actor, component);
+    if (component->hooks && component->hooks->lod_distance > 0.0f && (component->HasHook(HOOK_UPDATE) || component->HasHook(HOOK_LATE_UPDATE)))
+        update_lod.Add(actor, component);
+}
+
+void SceneDB::UnregisterComponent(Component* component)
+{
+    component_index.Remove(component);
+    if (component->IsParallel())
+    {
+        ScriptShards::Remove(component);
+    }
+    else
+    {
+        update_hooks.Remove(component);
+        late_update_hooks.Remove(component);
+    }
+    fixed_update_hooks.Remove(component);
+    update_lod.Remove(component);
+}
+
+void SceneDB::RelocateComponent(Component* component)
+{
+    component_index.Relocate(component);
+    if (component->IsParallel())
+    {
+        ScriptShards::Relocate(component);
+    }
+    else
+    {
+        update_hooks.Relocate(component);
+        late_update_hooks.Relocate(component);
+    }
+    fixed_update_hooks.Relocate(component);
+    update_lod.Relocate(component);
+}
+
+void SceneDB::ReregisterComponents(int type_id)
+{
+    // Registering appends to the index being walked
+    std::vector<ComponentIndex::Entry> entries = component_index.Get(type_id);
+    for (const ComponentIndex::Entry& entry : entries)
+    {
+        if (!entry.component)
+            continue;
+
+        UnregisterComponent(entry.component);
+        RegisterComponent(entry.actor, entry.component);
+        entry.actor->RefreshHookMask();
+    }
 }
 
 // Find actor from name
@@ -128,7 +481,7 @@ luabridge::LuaRef SceneDB::Find(const std::string& name)
 {
     auto it = name_to_actor.find(name);
     if (it != name_to_actor.end() && !it->second.empty())
-        return luabridge::LuaRef(lua_state, *it->second.begin());
+        return luabridge::LuaRef(lua_state, (*it->second.begin())->handle);
 
     return luabridge::LuaRef(lua_state);
 }
@@ -136,30 +489,420 @@ luabridge::LuaRef SceneDB::Find(const std::string& name)
 // Find all actors with name
 luabridge::LuaRef SceneDB::FindAll(const std::string& name)
 {
+    ScriptMemory::Scope memory_scope(MEMORY_RESULTS);
+
     luabridge::LuaRef table = luabridge::newTable(lua_state);
     int i = 1;
 
     auto it = name_to_actor.find(name);
     if (it != name_to_actor.end())
         for (Actor* a : it->second)
-            table[i++] = a;
+            table[i++] = a->handle;
+
+    return table;
+}
+
+// Find all actors that have every tag in mask, scanning the shortest of those tags' lists
+luabridge::LuaRef SceneDB::FindWithTags(uint32_t mask)
+{
+    ScriptMemory::Scope memory_scope(MEMORY_RESULTS);
+
+    luabridge::LuaRef table = luabridge::newTable(lua_state);
+    if (mask == 0)
+        return table;
+
+    const std::vector<Actor*>* shortest = nullptr;
+    for (int tag = 0; tag < TagDB::MAX_TAGS; tag++)
+        if ((mask & (1u << tag)) && (!shortest || tagged_actors[tag].size() < shortest->size()))
+            shortest = &tagged_actors[tag];
+
+    int i = 1;
+    for (Actor* a : *shortest)
+        if ((a->tags & mask) == mask)
+            table[i++] = a->handle;
+
+    return table;
+}
+
+// Find all actors on a layer
+luabridge::LuaRef SceneDB::FindInLayer(const std::string& layer_name)
+{
+    ScriptMemory::Scope memory_scope(MEMORY_RESULTS);
+
+    luabridge::LuaRef table = luabridge::newTable(lua_state);
+    int i = 1;
+
+    // A name no actor or config ever used is not a layer yet, and looking it up does not make it one
+    int layer = TagDB::FindLayer(layer_name);
+    if (layer == -1)
+        return table;
+
+    for (Actor* a : layer_actors[layer])
+        table[i++] = a->handle;
 
     return table;
 }
 
+// Replace an actor's tags, moving it between the tag lists if it is listed
+void SceneDB::SetTags(Actor* actor, uint32_t tags)
+{
+    bool listed = actor->layer_slot != -1;
+    if (listed)
+        UnindexActor(actor);
+
+    actor->tags = tags;
+
+    if (listed)
+        IndexActor(actor);
+}
+
+// Move an actor to another layer, its rigidbodies follow the new layer's collision mask
+void SceneDB::SetLayer(Actor* actor, int layer)
+{
+    if (actor->layer == layer)
+        return;
+
+    bool listed = actor->layer_slot != -1;
+    if (listed)
+        UnindexActor(actor);
+
+    actor->layer = layer;
+    actor->RefreshLayer();
+
+    if (listed)
+        IndexActor(actor);
+}
+
+// Give an actor a position in the spatial grid, queries see it from the next update
+void SceneDB::SetPosition(Actor* actor, float x, float y)
+{
+    if (actor->alive)
+        spatial_grid.Move(actor, x, y);
+}
+
+void SceneDB::ClearPosition(Actor* actor)
+{
+    spatial_grid.Remove(actor);
+}
+
+luabridge::LuaRef SceneDB::GetPosition(const Actor* actor)
+{
+    float x, y;
+    if (!spatial_grid.GetPosition(actor, x, y))
+        return luabridge::LuaRef(lua_state);
+    return luabridge::LuaRef(lua_state, b2Vec2(x, y));
+}
+
+// Find all actors with a position within radius of a point. The table is reused by the next call
+luabridge::LuaRef SceneDB::FindInRadius(float x, float y, float radius)
+{
+    static std::vector<Actor*> found;
+    found.clear();
+    spatial_grid.QueryRadius(x, y, radius, found);
+    return FillActorResult("radius", found);
+}
+
+// Find all actors with a position inside the rectangle between two corners. The table is reused by the next call
+luabridge::LuaRef SceneDB::FindInRect(float x1, float y1, float x2, float y2)
+{
+    static std::vector<Actor*> found;
+    found.clear();
+    spatial_grid.QueryRect(std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2), found);
+    return FillActorResult("rect", found);
+}
+
+// Measure update LOD from an actor instead of the camera, nil goes back to the camera
+void SceneDB::SetUpdateFocus(luabridge::LuaRef actor)
+{
+    has_update_focus = actor.isUserdata();
+    if (has_update_focus)
+        update_focus = actor.cast<ActorHandle>();
+}
+
+// Focus actor's position while it exists and has one, otherwise the camera's
+b2Vec2 SceneDB::GetUpdateFocus()
+{
+    b2Vec2 focus(Renderer::GetCameraX(), Renderer::GetCameraY());
+    if (has_update_focus)
+        if (Actor* actor = ActorPool::Resolve(update_focus))
+            UpdateLOD::FindPosition(spatial_grid, actor, focus);
+    return focus;
+}
+
+// Overwrite a spatial query's table with the shared handles of the actors found
+luabridge::LuaRef SceneDB::FillActorResult(const std::string& query_name, const std::vector<Actor*>& actors)
+{
+    ScriptMemory::Scope memory_scope(MEMORY_RESULTS);
+
+    auto it = spatial_query_results.find(query_name);
+    if (it == spatial_query_results.end())
+        it = spatial_query_results.emplace(query_name, QueryResult{ luabridge::newTable(lua_state) }).first;
+    QueryResult& result = it->second;
+
+    result.table.push(lua_state);
+    int size = 0;
+
+    for (Actor* a : actors)
+    {
+        PushHandle(a->handle);
+        lua_rawseti(lua_state, -2, ++size);
+    }
+
+    for (int i = size + 1; i <= result.size; i++)
+    {
+        lua_pushnil(lua_state);
+        lua_rawseti(lua_state, -2, i);
+    }
+    result.size = size;
+
+    lua_pop(lua_state, 1);
+    return result.table;
+}
+
+// Push the cached userdata for a handle, replacing the slot's entry once its actor is reissued
+void SceneDB::PushHandle(ActorHandle handle)
+{
+    if (!handle_userdata)
+        handle_userdata = std::make_unique<luabridge::LuaRef>(luabridge::newTable(lua_state));
+
+    handle_userdata->push(lua_state);
+    lua_rawgeti(lua_state, -1, static_cast<lua_Integer>(handle.index) + 1);
+    if (lua_isuserdata(lua_state, -1) && luabridge::Stack<ActorHandle>::get(lua_state, -1) == handle)
+    {
+        lua_remove(lua_state, -2);
+        return;
+    }
+    lua_pop(lua_state, 1);
+
+    luabridge::Stack<ActorHandle>::push(lua_state, handle);
+    lua_pushvalue(lua_state, -1);
+    lua_rawseti(lua_state, -3, static_cast<lua_Integer>(handle.index) + 1);
+    lua_remove(lua_state, -2);
+}
+
+// Return every live component of a type in the scene, optionally only on actors with a given name.
+// The table is reused by the next query of the same type, with or without a name as this one
+luabridge::LuaRef SceneDB::Query(const std::string& type_name, luabridge::LuaRef actor_name)
+{
+    ScriptMemory::Scope memory_scope(MEMORY_RESULTS);
+
+    int type_id = ComponentDB::FindTypeID(type_name);
+    if (type_id == -1)
+        return luabridge::newTable(lua_state);
+
+    std::unordered_map<int, QueryResult>& results = actor_name.isString() ? name_query_results : type_query_results;
+
+    auto it = results.find(type_id);
+    if (it == results.end())
+        it = results.emplace(type_id, QueryResult{ luabridge::newTable(lua_state) }).first;
+    QueryResult& result = it->second;
+
+    result.table.push(lua_state);
+    int size = 0;
+
+    if (actor_name.isString())
+    {
+        auto named = name_to_actor.find(actor_name.cast<std::string>());
+        if (named != name_to_actor.end())
+        {
+            for (Actor* a : named->second)
+            {
+                for (Component& c : a->components)
+                {
+                    if (c.type_id != type_id || c.index_slot == -1)
+                        continue;
+
+                    c.component_ref->push(lua_state);
+                    lua_rawseti(lua_state, -2, ++size);
+                }
+            }
+        }
+    }
+    else
+    {
+        for (const ComponentIndex::Entry& e : component_index.Get(type_id))
+        {
+            if (!e.component)
+                continue;
+
+            e.component->component_ref->push(lua_state);
+            lua_rawseti(lua_state, -2, ++size);
+        }
+    }
+
+    // Clear what is left of the previous fill
+    for (int i = size + 1; i <= result.size; i++)
+    {
+        lua_pushnil(lua_state);
+        lua_rawseti(lua_state, -2, i);
+    }
+    result.size = size;
+
+    lua_pop(lua_state, 1);
+    return result.table;
+}
+
+// Call callback with every live component of a type, stop early if it returns false
+void SceneDB::ForEach(const std::string& type_name, luabridge::LuaRef callback)
+{
+    int type_id = ComponentDB::FindTypeID(type_name);
+    if (type_id == -1 || !callback.isFunction())
+        return;
+
+    callback.push(lua_state);
+    int callback_index = lua_gettop(lua_state);
+
+    // Components registered by the callback wait for the next query, holes are skipped
+    size_t count = component_index.Get(type_id).size();
+    for (size_t i = 0; i < count; i++)
+    {
+        ComponentIndex::Entry e = component_index.Get(type_id)[i];
+        if (!e.component)
+            continue;
+
+        lua_pushvalue(lua_state, callback_index);
+        e.component->component_ref->push(lua_state);
+        if (lua_pcall(lua_state, 1, 1, 0) != LUA_OK)
+        {
+            const char* message = lua_tostring(lua_state, -1);
+            EngineUtils::ReportError(e.actor->GetName(), message ? message : "error object is not a string");
+            lua_pop(lua_state, 1);
+            continue;
+        }
+
+        bool stop = lua_isboolean(lua_state, -1) && !lua_toboolean(lua_state, -1);
+        lua_pop(lua_state, 1);
+        if (stop)
+            break;
+    }
+
+    lua_pop(lua_state, 1);
+}
+
 // Create new Actor and add to queue
 luabridge::LuaRef SceneDB::Instantiate(const std::string& actor_template_name)
 {
-    Actor* new_actor = new_actors_to_add.emplace_back(new Actor(*TemplateDB::GetTemplate(actor_template_name)));
-    name_to_actor[new_actor->actor_name].insert(new_actor);
-    return luabridge::LuaRef(lua_state, new_actor);
+    Actor* new_actor = Spawn(TemplateDB::GetSpawnPlan(actor_template_name));
+    return luabridge::LuaRef(lua_state, new_actor->handle);
+}
+
+// Create count actors from one template, returns an array of their handles
+luabridge::LuaRef SceneDB::InstantiateMany(const std::string& actor_template_name, int count)
+{
+    ScriptMemory::Scope memory_scope(MEMORY_RESULTS);
+
+    const SpawnPlan& plan = TemplateDB::GetSpawnPlan(actor_template_name);
+    count = std::max(count, 0);
+
+    lua_createtable(lua_state, count, 0);
+    for (int i = 1; i <= count; i++)
+    {
+        luabridge::Stack<ActorHandle>::push(lua_state, Spawn(plan)->handle);
+        lua_rawseti(lua_state, -2, i);
+    }
+    return luabridge::LuaRef::fromStack(lua_state);
+}
+
+// Build an actor from a plan, or reuse a parked one, and queue it for the next frame
+Actor* SceneDB::Spawn(const SpawnPlan& plan)
+{
+    Actor* new_actor = nullptr;
+    if (plan.pool_size > 0)
+    {
+        std::vector<Actor*>& parked = parked_actors[&plan].actors;
+        if (!parked.empty())
+        {
+            new_actor = parked.back();
+            parked.pop_back();
+            new_actor->Reuse();
+        }
+    }
+
+    if (!new_actor)
+        new_actor = ActorPool::Create(plan);
+
+    new_actors_to_add.push_back(new_actor);
+    IndexActor(new_actor);
+    return new_actor;
 }
 
 // Mark actor for deletion, erase from name database
-void SceneDB::Destroy(Actor* victim)
+void SceneDB::Destroy(ActorHandle handle)
 {
+    Actor* victim = ActorPool::Resolve(handle);
+    if (!victim || !victim->alive)
+        return;
+
     victim->Destroy();
-    name_to_actor[victim->actor_name].erase(victim);
+    UnindexActor(victim);
+    spatial_grid.Remove(victim);
+    dying_actors.push_back(victim);
+}
+
+// Take an actor of a pooled template out of the scene and keep it for the next Instantiate.
+// Actors that cannot be parked are destroyed instead
+void SceneDB::Release(ActorHandle handle)
+{
+    Actor* actor = ActorPool::Resolve(handle);
+    if (!actor || !actor->alive)
+        return;
+
+    if (!CanPark(actor))
+    {
+        Destroy(handle);
+        return;
+    }
+
+    parked_actors[actor->plan].pending++;
+    actor->Release();
+    UnindexActor(actor);
+    spatial_grid.Remove(actor);
+    dying_actors.push_back(actor);
+}
+
+// An actor can be parked if its template is pooled, the pool has room and it still has exactly the template's components
+bool SceneDB::CanPark(const Actor* actor)
+{
+    const SpawnPlan* plan = actor->plan;
+    if (!plan || plan->pool_size <= 0)
+        return false;
+
+    const ParkedActors& parked = parked_actors[plan];
+    if (parked.actors.size() + parked.pending >= static_cast<size_t>(plan->pool_size))
+        return false;
+
+    if (!actor->components_to_add.empty() || actor->components.size() != plan->source->components.size())
+        return false;
+
+    for (size_t i = 0; i < actor->components.size(); i++)
+    {
+        const Component& component = actor->components[i];
+        if (!component.alive || component.key != plan->source->components[i].key)
+            return false;
+    }
+    return true;
+}
+
+// Reset a released actor and add it to its template's pool
+void SceneDB::Park(Actor* actor)
+{
+    ParkedActors& parked = parked_actors[actor->plan];
+    parked.pending--;
+
+    // Park reissues the handle, so the owner's coroutines are looked up under the old one
+    ActorHandle handle = actor->GetHandle();
+    actor->Park();
+    CoroutineScheduler::StopOwned(handle);
+    parked.actors.push_back(actor);
+}
+
+// Return a destroyed actor's slot to the pool once nothing in the scene points at it
+void SceneDB::Reclaim(Actor* actor)
+{
+    UnindexActor(actor);
+    spatial_grid.Remove(actor);
+    CoroutineScheduler::StopOwned(actor->GetHandle());
+    ActorPool::Release(actor);
 }
 
 void SceneDB::QueueLoad(const std::string& scene_name)
@@ -172,7 +915,8 @@ std::string& SceneDB::GetCurrent()
     return current_scene;
 }
 
-void SceneDB::DontDestroy(Actor* actor)
+void SceneDB::DontDestroy(ActorHandle handle)
 {
-    actor->retain = true;
+    if (Actor* actor = ActorPool::Resolve(handle))
+        actor->retain = true;
 }
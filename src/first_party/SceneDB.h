@@ -3,7 +3,12 @@
 
 #include "Actor.h"
 #include "EditorManager.h"
+#include "ComponentIndex.h"
+#include "HookList.h"
+#include "SpatialGrid.h"
+#include "UpdateLOD.h"
 
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -13,21 +18,51 @@
 class SceneDB
 {
 public:
+    static void Init(const rapidjson::Document& doc);
     static void LoadScene(const std::string scene_name);
 
     static void RestartScene();
 
     static void UpdateActors();
+    static void FixedUpdateActors();
 
     static luabridge::LuaRef Find(const std::string& name);
     static luabridge::LuaRef FindAll(const std::string& name);
 
+    static luabridge::LuaRef FindWithTags(uint32_t mask);
+    static luabridge::LuaRef FindInLayer(const std::string& layer_name);
+    static void SetTags(Actor* actor, uint32_t tags);
+    static void SetLayer(Actor* actor, int layer);
+
+    static void SetPosition(Actor* actor, float x, float y);
+    static void ClearPosition(Actor* actor);
+    static luabridge::LuaRef GetPosition(const Actor* actor);
+    static luabridge::LuaRef FindInRadius(float x, float y, float radius);
+    static luabridge::LuaRef FindInRect(float x1, float y1, float x2, float y2);
+
+    static void SetUpdateFocus(luabridge::LuaRef actor);
+
+    static luabridge::LuaRef Query(const std::string& type_name, luabridge::LuaRef actor_name);
+    static void ForEach(const std::string& type_name, luabridge::LuaRef callback);
+
     static luabridge::LuaRef Instantiate(const std::string& actor_template_name);
-    static void Destroy(Actor* victim);
+    static luabridge::LuaRef InstantiateMany(const std::string& actor_template_name, int count);
+    static void Destroy(ActorHandle handle);
+    static void Release(ActorHandle handle);
+
+    static void RegisterComponent(Actor* actor, Component* component);
+    static void UnregisterComponent(Component* component);
+    static void RelocateComponent(Component* component);
+
+    // Register the live components of a hot reloaded type again, for its new lifecycle functions and intervals
+    static void ReregisterComponents(int type_id);
+
+    static void QueueAddedComponents(Actor* actor);
+    static void QueueRemovedComponents(Actor* actor);
 
     static void QueueLoad(const std::string& scene_name);
     static std::string& GetCurrent();
-    static void DontDestroy(Actor* actor);
+    static void DontDestroy(ActorHandle handle);
     static inline std::string next_scene;
 
 private:
@@ -40,17 +75,84 @@ private:
     };
     static inline std::unordered_map<std::string, std::set<Actor*, CompareActors>> name_to_actor;
 
+    // Listed actors by tag bit and by layer, unordered
+    static inline std::vector<Actor*> tagged_actors[TagDB::MAX_TAGS];
+    static inline std::vector<Actor*> layer_actors[TagDB::MAX_LAYERS];
+
+    static void IndexActor(Actor* actor);
+    static void UnindexActor(Actor* actor);
+    static void ClearActorIndex();
+
     static void LoadActors(const std::string& path);
     static void UnloadScene();
 
+    // Per-frame lifecycle functions, only components that implement them are visited
+    static inline HookList update_hooks = HookList(HOOK_UPDATE);
+    static inline HookList late_update_hooks = HookList(HOOK_LATE_UPDATE);
+    static inline HookList fixed_update_hooks = HookList(HOOK_FIXED_UPDATE);
+
+    // Every registered component by type, for Query and ForEach
+    static inline ComponentIndex component_index;
+
+    // Tables returned by Query, one per type for all of its components and one for name-filtered queries,
+    // refilled by the next query of the same kind. Names are not keys, games may generate any number of them
+    struct QueryResult
+    {
+        luabridge::LuaRef table;
+        int size = 0;
+    };
+    static inline std::unordered_map<int, QueryResult> type_query_results;
+    static inline std::unordered_map<int, QueryResult> name_query_results;
+
+    // Actors with a position, rebuilt at the start of each update. Each spatial query refills its own table
+    static inline SpatialGrid spatial_grid;
+    static inline std::unordered_map<std::string, QueryResult> spatial_query_results;
+    static luabridge::LuaRef FillActorResult(const std::string& query_name, const std::vector<Actor*>& actors);
+
+    // Pool index -> the handle userdata last given out for that slot, so results do not allocate one per actor
+    static inline std::unique_ptr<luabridge::LuaRef> handle_userdata;
+    static void PushHandle(ActorHandle handle);
+
+    // Components of types with an lod_distance, measured from the focus actor or else the camera
+    static inline UpdateLOD update_lod;
+    static inline ActorHandle update_focus;
+    static inline bool has_update_focus = false;
+    static b2Vec2 GetUpdateFocus();
+    static void RegisterActor(Actor* actor);
+    static Actor* Spawn(const SpawnPlan& plan);
+    static void Reclaim(Actor* actor);
+    static void Park(Actor* actor);
+    static bool CanPark(const Actor* actor);
+
+    // Released actors of pooled templates. pending counts the ones released this frame
+    struct ParkedActors
+    {
+        std::vector<Actor*> actors;
+        size_t pending = 0;
+    };
+    static inline std::unordered_map<const SpawnPlan*, ParkedActors> parked_actors;
+
     static inline int next_component = 1;
     static inline std::deque<Actor*> actors_to_add;
     static inline std::deque<Actor*> new_actors_to_add;
 
+    // Actors destroyed or released since the last update, and the ones leaving the scene during this update
+    static inline std::vector<Actor*> dying_actors;
+    static inline std::vector<Actor*> dead_actors;
+
+    // Actors with queued component changes, only these are visited when the changes are applied
+    static inline std::vector<Actor*> actors_adding_components;
+    static inline std::vector<Actor*> actors_removing_components;
+
+    static void AddToScene(Actor* actor);
+    static void RemoveFromScene(Actor* actor);
+
     static inline std::string current_scene;
     static inline bool stopped = true;
 
     friend class EditorManager;
+    friend class Engine;
+    friend class ScriptShards;
 };
 
 #endif
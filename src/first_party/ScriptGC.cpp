@@ -0,0 +1,181 @@
+#include "ScriptGC.h"
+
+#include "ComponentDB.h"
+#include "EngineUtils.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    int64_t NowUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+// Read lua_gc_mode, lua_gc_budget_ms and lua_gc_pause from game.config
+void ScriptGC::Init(const rapidjson::Document& doc)
+{
+    std::string mode_name = "incremental";
+    EngineUtils::GetConfigValue(doc, "lua_gc_mode", mode_name);
+    if (mode_name == "incremental")
+        mode = MODE_INCREMENTAL;
+    else if (mode_name == "generational")
+        mode = MODE_GENERATIONAL;
+    else if (mode_name == "lua")
+        mode = MODE_LUA;
+    else
+    {
+        std::cout << "error: lua_gc_mode " << mode_name << " is not incremental, generational or lua";
+        exit(0);
+    }
+
+    EngineUtils::GetConfigValue(doc, "lua_gc_budget_ms", budget_ms);
+    budget_ms = std::max(budget_ms, 0.0f);
+
+    EngineUtils::GetConfigValue(doc, "lua_gc_pause", pause);
+    pause = std::max(pause, 100);
+}
+
+// A new main state, as editor Play creates, takes over the old one's entry
+void ScriptGC::AddState(lua_State* L, bool is_main)
+{
+    auto old_main = std::find_if(states.begin(), states.end(), [](const State& s) { return s.is_main; });
+    if (is_main && old_main != states.end())
+        states.erase(old_main);
+
+    State& state = states.emplace_back();
+    state.L = L;
+    state.is_main = is_main;
+    state.cycle_end_kb = lua_gc(L, LUA_GCCOUNT);
+    state.heap_kb = state.cycle_end_kb;
+
+    if (mode == MODE_LUA)
+        return;
+
+    if (mode == MODE_GENERATIONAL)
+        lua_gc(L, LUA_GCGEN, 0, 0);
+    else
+        lua_gc(L, LUA_GCINC, 0, 0, 0);
+    lua_gc(L, LUA_GCSTOP);
+}
+
+void ScriptGC::Step()
+{
+    if (mode == MODE_LUA || states.empty())
+        return;
+
+    PROFILE_ZONE("ScriptGC::Step");
+
+    // Separate states share nothing, so the shards collect on the workers while the main state, which
+    // only the main thread may touch, collects here
+    JobSystem::Counter counter = 0;
+    State* main_state = nullptr;
+    for (State& state : states)
+    {
+        if (state.is_main)
+            main_state = &state;
+        else
+        {
+            counter.fetch_add(1);
+            JobSystem::Submit([&state]() { StepState(state); }, &counter);
+        }
+    }
+    if (main_state)
+        StepState(*main_state);
+    JobSystem::Wait(counter);
+
+    int shard_heap_kb = 0;
+    for (const State& state : states)
+    {
+        if (state.is_main)
+            PROFILE_COUNTER("Lua heap KB", state.heap_kb);
+        else
+            shard_heap_kb += state.heap_kb;
+    }
+    PROFILE_COUNTER("Lua shard heap KB", shard_heap_kb);
+}
+
+// Incremental states step until the budget runs out or the cycle ends, and only start a cycle once the heap
+// has grown by pause percent. A state that falls twice that far behind finishes its cycle regardless.
+// Generational states do one minor collection, or a major one once the heap has grown by pause percent
+void ScriptGC::StepState(State& state)
+{
+    int64_t start_us = NowUs();
+    int heap_kb = lua_gc(state.L, LUA_GCCOUNT);
+    int64_t threshold_kb = static_cast<int64_t>(state.cycle_end_kb) * pause / 100;
+
+    if (mode == MODE_GENERATIONAL)
+    {
+        if (heap_kb >= threshold_kb)
+        {
+            lua_gc(state.L, LUA_GCCOLLECT);
+            state.cycle_end_kb = lua_gc(state.L, LUA_GCCOUNT);
+            state.cycles++;
+        }
+        else
+        {
+            lua_gc(state.L, LUA_GCSTEP, 0);
+        }
+    }
+    else if (state.collecting || heap_kb >= threshold_kb)
+    {
+        state.collecting = true;
+        bool forced = heap_kb >= threshold_kb * 2;
+        int64_t deadline_us = start_us + static_cast<int64_t>(budget_ms * 1000.0f);
+
+        do
+        {
+            if (lua_gc(state.L, LUA_GCSTEP, 0))
+            {
+                state.collecting = false;
+                state.cycle_end_kb = lua_gc(state.L, LUA_GCCOUNT);
+                state.cycles++;
+                if (forced)
+                    state.forced_cycles++;
+                break;
+            }
+        } while (forced || NowUs() < deadline_us);
+    }
+
+    state.heap_kb = lua_gc(state.L, LUA_GCCOUNT);
+    state.step_us = NowUs() - start_us;
+    state.max_step_us = std::max(state.max_step_us, state.step_us);
+}
+
+// { mode, heap_kb, step_ms, max_step_ms, cycles, forced_cycles, shard_heap_kb } for the main state,
+// step_ms being the last frame's collection time. Shards only report their total heap
+luabridge::LuaRef ScriptGC::GetStats()
+{
+    static const char* const MODE_NAMES[] = { "incremental", "generational", "lua" };
+
+    luabridge::LuaRef stats = luabridge::newTable(lua_state);
+    stats["mode"] = MODE_NAMES[mode];
+
+    int shard_heap_kb = 0;
+    for (State& state : states)
+    {
+        // Collectors left to Lua are not stepped, so read their heaps now
+        if (mode == MODE_LUA)
+            state.heap_kb = lua_gc(state.L, LUA_GCCOUNT);
+
+        if (!state.is_main)
+        {
+            shard_heap_kb += state.heap_kb;
+            continue;
+        }
+
+        stats["heap_kb"] = state.heap_kb;
+        stats["step_ms"] = state.step_us / 1000.0;
+        stats["max_step_ms"] = state.max_step_us / 1000.0;
+        stats["cycles"] = state.cycles;
+        stats["forced_cycles"] = state.forced_cycles;
+    }
+    stats["shard_heap_kb"] = shard_heap_kb;
+    return stats;
+}
@@ -0,0 +1,56 @@
+#ifndef SCRIPT_GC_H
+#define SCRIPT_GC_H
+
+#include "lua/lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+#include "rapidjson/document.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Engine paced Lua garbage collection. Each Lua state's own collector is stopped and Step does its work
+// at the end of the frame within lua_gc_budget_ms, so collections never land in the middle of the scripts.
+// lua_gc_mode "generational" runs one minor collection per frame instead, and "lua" leaves the collectors alone
+class ScriptGC
+{
+public:
+    static void Init(const rapidjson::Document& doc);
+
+    // Put a new Lua state under the configured mode
+    static void AddState(lua_State* L, bool is_main);
+
+    // Collect in every state, the shards on the job system alongside the main state on the calling thread
+    static void Step();
+
+    static luabridge::LuaRef GetStats();
+
+private:
+    enum Mode { MODE_INCREMENTAL, MODE_GENERATIONAL, MODE_LUA };
+
+    struct State
+    {
+        lua_State* L;
+        bool is_main;
+
+        // Heap size when the last cycle finished, the next one starts once it grows by pause percent
+        int cycle_end_kb = 0;
+        bool collecting = false;
+
+        int heap_kb = 0;
+        int64_t step_us = 0;
+        int64_t max_step_us = 0;
+        int cycles = 0;
+        int forced_cycles = 0;
+    };
+
+    static void StepState(State& state);
+
+    static inline Mode mode = MODE_INCREMENTAL;
+    static inline float budget_ms = 1.0f;
+    static inline int pause = 200;
+
+    static inline std::vector<State> states;
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include "ScriptMemory.h"
+
+#include "ComponentDB.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+lua_State* ScriptMemory::NewState()
+{
+    Heap* heap = new Heap();
+    heaps.push_back(heap);
+
+    lua_State* L = lua_newstate(&Allocate, heap);
+    lua_atpanic(L, &Panic);
+    return L;
+}
+
+// Sum the frame's counts from every heap and start the next frame. Runs between frames, when no state is running
+void ScriptMemory::EndFrame()
+{
+    last_frame_allocations = 0;
+    last_frame_bytes = 0;
+    for (Heap* heap : heaps)
+    {
+        last_frame_allocations += heap->frame.allocations;
+        last_frame_bytes += heap->frame.bytes;
+        heap->frame = Counter();
+    }
+
+    PROFILE_COUNTER("Lua allocations", static_cast<int64_t>(last_frame_allocations));
+}
+
+// { live_kb, pooled_kb, allocations, allocated_kb, frame_allocations, frame_allocated_kb, categories, types } over every state.
+// categories and types map names to { allocations, allocated_kb } since the start, frame_ counts are for the last frame
+luabridge::LuaRef ScriptMemory::GetStats()
+{
+    size_t live_bytes = 0;
+    size_t pooled_bytes = 0;
+    Counter categories[MEMORY_CATEGORY_COUNT];
+    std::vector<Counter> types;
+
+    for (Heap* heap : heaps)
+    {
+        live_bytes += heap->live_bytes;
+        pooled_bytes += heap->pages.size() * PAGE_SIZE;
+
+        for (int i = 0; i < MEMORY_CATEGORY_COUNT; i++)
+        {
+            categories[i].allocations += heap->categories[i].allocations;
+            categories[i].bytes += heap->categories[i].bytes;
+        }
+
+        types.resize(std::max(types.size(), heap->types.size()));
+        for (size_t i = 0; i < heap->types.size(); i++)
+        {
+            types[i].allocations += heap->types[i].allocations;
+            types[i].bytes += heap->types[i].bytes;
+        }
+    }
+
+    luabridge::LuaRef stats = luabridge::newTable(lua_state);
+    stats["live_kb"] = live_bytes / 1024.0;
+    stats["pooled_kb"] = pooled_bytes / 1024.0;
+    stats["frame_allocations"] = last_frame_allocations;
+    stats["frame_allocated_kb"] = last_frame_bytes / 1024.0;
+
+    Counter total;
+    luabridge::LuaRef category_table = luabridge::newTable(lua_state);
+    for (int i = 0; i < MEMORY_CATEGORY_COUNT; i++)
+    {
+        luabridge::LuaRef entry = luabridge::newTable(lua_state);
+        entry["allocations"] = categories[i].allocations;
+        entry["allocated_kb"] = categories[i].bytes / 1024.0;
+        category_table[MEMORY_CATEGORY_NAMES[i]] = entry;
+
+        total.allocations += categories[i].allocations;
+        total.bytes += categories[i].bytes;
+    }
+    stats["allocations"] = total.allocations;
+    stats["allocated_kb"] = total.bytes / 1024.0;
+    stats["categories"] = category_table;
+
+    luabridge::LuaRef type_table = luabridge::newTable(lua_state);
+    for (size_t i = 0; i < types.size(); i++)
+    {
+        if (types[i].allocations == 0)
+            continue;
+
+        luabridge::LuaRef entry = luabridge::newTable(lua_state);
+        entry["allocations"] = types[i].allocations;
+        entry["allocated_kb"] = types[i].bytes / 1024.0;
+        type_table[ComponentDB::GetTypeName(static_cast<int>(i))] = entry;
+    }
+    stats["types"] = type_table;
+    return stats;
+}
+
+// lua_Alloc. Blocks keep their pool for as long as their size class stays the same, and only growth is counted
+void* ScriptMemory::Allocate(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+    Heap& heap = *static_cast<Heap*>(ud);
+
+    // Without a block, osize is the type of the object being created
+    size_t old_size = ptr ? osize : 0;
+    MemoryCategory block_category = (!ptr && osize == LUA_TUSERDATA) ? MEMORY_USERDATA : category;
+
+    if (nsize == 0)
+    {
+        if (!ptr)
+            return nullptr;
+
+        heap.live_bytes -= old_size;
+        if (old_size <= MAX_POOLED_SIZE)
+            PoolFree(heap, ptr, GetSizeClass(old_size));
+        else
+            std::free(ptr);
+        return nullptr;
+    }
+
+    bool old_pooled = ptr && old_size <= MAX_POOLED_SIZE;
+    bool new_pooled = nsize <= MAX_POOLED_SIZE;
+
+    void* block = nullptr;
+    if (ptr && !old_pooled && !new_pooled)
+    {
+        block = std::realloc(ptr, nsize);
+    }
+    else if (old_pooled && new_pooled && GetSizeClass(old_size) == GetSizeClass(nsize))
+    {
+        block = ptr;
+    }
+    else
+    {
+        block = new_pooled ? PoolAllocate(heap, GetSizeClass(nsize)) : std::malloc(nsize);
+        if (block && ptr)
+        {
+            std::memcpy(block, ptr, std::min(old_size, nsize));
+            if (old_pooled)
+                PoolFree(heap, ptr, GetSizeClass(old_size));
+            else
+                std::free(ptr);
+        }
+    }
+
+    // Lua expects shrinking to succeed. The old block is at least as big, and it is fine for it
+    // to end up in a smaller size class's pool
+    if (!block && ptr && nsize <= old_size)
+        block = ptr;
+    if (!block)
+        return nullptr;
+
+    heap.live_bytes += nsize;
+    heap.live_bytes -= old_size;
+    if (nsize > old_size)
+        Count(heap, nsize - old_size, block_category);
+    return block;
+}
+
+void* ScriptMemory::PoolAllocate(Heap& heap, size_t size_class)
+{
+    void*& free_list = heap.free_lists[size_class];
+    if (free_list)
+    {
+        void* block = free_list;
+        free_list = *static_cast<void**>(block);
+        return block;
+    }
+
+    // Carve a new block off the current page, the tail of a used up page is left unused
+    size_t block_size = (size_class + 1) * SIZE_CLASS_BYTES;
+    if (heap.page_left < block_size)
+    {
+        char* page = static_cast<char*>(std::malloc(PAGE_SIZE));
+        if (!page)
+            return nullptr;
+
+        heap.pages.push_back(page);
+        heap.page_cursor = page;
+        heap.page_left = PAGE_SIZE;
+    }
+
+    void* block = heap.page_cursor;
+    heap.page_cursor += block_size;
+    heap.page_left -= block_size;
+    return block;
+}
+
+void ScriptMemory::PoolFree(Heap& heap, void* block, size_t size_class)
+{
+    void*& free_list = heap.free_lists[size_class];
+    *static_cast<void**>(block) = free_list;
+    free_list = block;
+}
+
+void ScriptMemory::Count(Heap& heap, size_t size, MemoryCategory block_category)
+{
+    heap.categories[block_category].Add(size);
+    heap.frame.Add(size);
+
+    if (type_id < 0)
+        return;
+
+    if (heap.types.size() <= static_cast<size_t>(type_id))
+        heap.types.resize(type_id + 1);
+    heap.types[type_id].Add(size);
+}
+
+// Errors outside of a protected call end the program, say why first
+int ScriptMemory::Panic(lua_State* L)
+{
+    const char* message = lua_tostring(L, -1);
+    std::cout << "error: unprotected Lua error: " << (message ? message : "error object is not a string") << std::endl;
+    return 0;
+}
@@ -0,0 +1,129 @@
+#ifndef SCRIPT_MEMORY_H
+#define SCRIPT_MEMORY_H
+
+#include "lua/lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What the engine was doing when Lua asked for memory. Anything not claimed by an engine scope is the scripts' own,
+// and new userdata is counted as userdata wherever it comes from
+enum MemoryCategory
+{
+    MEMORY_SCRIPTS,
+    MEMORY_COMPONENTS,
+    MEMORY_EVENTS,
+    MEMORY_RESULTS,
+    MEMORY_USERDATA,
+    MEMORY_CATEGORY_COUNT
+};
+
+inline const char* const MEMORY_CATEGORY_NAMES[MEMORY_CATEGORY_COUNT] = {
+    "scripts", "components", "events", "results", "userdata"
+};
+
+// Allocator behind every Lua state. Blocks up to MAX_POOLED_SIZE bytes come from per-state size class pools,
+// larger ones from malloc. Allocations are counted per category, per component type whose lifecycle function
+// is running and per frame
+class ScriptMemory
+{
+public:
+    // A Lua state using the engine allocator, each state gets its own pools so shards never share one
+    static lua_State* NewState();
+
+    // Close the frame's allocation count
+    static void EndFrame();
+
+    static luabridge::LuaRef GetStats();
+
+    // Counts the allocations of the enclosing scope under category
+    class Scope
+    {
+    public:
+        explicit Scope(MemoryCategory scope_category) : previous(category) { category = scope_category; }
+        ~Scope() { category = previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        MemoryCategory previous;
+    };
+
+    // Counts the allocations of the enclosing scope as a script of the given component type
+    class TypeScope
+    {
+    public:
+        explicit TypeScope(int scope_type_id) : previous_category(category), previous_type_id(type_id)
+        {
+            category = MEMORY_SCRIPTS;
+            type_id = scope_type_id;
+        }
+        ~TypeScope()
+        {
+            category = previous_category;
+            type_id = previous_type_id;
+        }
+
+        TypeScope(const TypeScope&) = delete;
+        TypeScope& operator=(const TypeScope&) = delete;
+
+    private:
+        MemoryCategory previous_category;
+        int previous_type_id;
+    };
+
+private:
+    struct Counter
+    {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+
+        void Add(size_t size)
+        {
+            allocations++;
+            bytes += size;
+        }
+    };
+
+    static constexpr size_t SIZE_CLASS_BYTES = 16;
+    static constexpr size_t MAX_POOLED_SIZE = 256;
+    static constexpr size_t SIZE_CLASS_COUNT = MAX_POOLED_SIZE / SIZE_CLASS_BYTES;
+    static constexpr size_t PAGE_SIZE = 64 * 1024;
+
+    static size_t GetSizeClass(size_t size) { return (size - 1) / SIZE_CLASS_BYTES; }
+
+    // One state's pools and counters, only touched by the thread running that state
+    struct Heap
+    {
+        // Freed pooled blocks hold the pointer to the next free block of their class
+        void* free_lists[SIZE_CLASS_COUNT] = {};
+        std::vector<void*> pages;
+        char* page_cursor = nullptr;
+        size_t page_left = 0;
+
+        size_t live_bytes = 0;
+        Counter categories[MEMORY_CATEGORY_COUNT];
+        std::vector<Counter> types;
+        Counter frame;
+    };
+
+    static void* Allocate(void* ud, void* ptr, size_t osize, size_t nsize);
+    static void* PoolAllocate(Heap& heap, size_t size_class);
+    static void PoolFree(Heap& heap, void* block, size_t size_class);
+    static void Count(Heap& heap, size_t size, MemoryCategory block_category);
+
+    static int Panic(lua_State* L);
+
+    // Heaps live for the whole run like their states, so blocks freed during exit still have somewhere to go
+    static inline std::vector<Heap*> heaps;
+    static inline uint64_t last_frame_allocations = 0;
+    static inline uint64_t last_frame_bytes = 0;
+
+    static inline thread_local MemoryCategory category = MEMORY_SCRIPTS;
+    static inline thread_local int type_id = -1;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "ScriptProfiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+// Write the profile to ENGINE_SCRIPT_PROFILE, or script_profile.csv, when the program exits
+void ScriptProfiler::Init()
+{
+#ifdef ENGINE_PROFILER
+    if (!exit_csv_path.empty())
+        return;
+
+    const char* path = std::getenv("ENGINE_SCRIPT_PROFILE");
+    exit_csv_path = path ? path : "script_profile.csv";
+    std::atexit(&WriteOnExit);
+#endif
+}
+
+void ScriptProfiler::CallStats::Add(int64_t duration_ns)
+{
+    calls++;
+    total_ns += duration_ns;
+    max_ns = std::max(max_ns, duration_ns);
+}
+
+void ScriptProfiler::Record(const std::string& type, ComponentHook hook, const std::string& actor_name, int64_t duration_ns)
+{
+    type_stats[type][hook].Add(duration_ns);
+    actor_stats[actor_name].Add(duration_ns);
+}
+
+// Return { types = { [type] = { [hook] = stats } }, actors = { stats sorted by cost } }, times in milliseconds
+luabridge::LuaRef ScriptProfiler::GetProfile()
+{
+    luabridge::LuaRef profile = luabridge::newTable(lua_state);
+    luabridge::LuaRef types = luabridge::newTable(lua_state);
+    luabridge::LuaRef actors = luabridge::newTable(lua_state);
+
+    for (const auto& [type, hooks] : type_stats)
+    {
+        luabridge::LuaRef type_table = luabridge::newTable(lua_state);
+        for (int hook = 0; hook < HOOK_COUNT; hook++)
+        {
+            const CallStats& stats = hooks[hook];
+            if (stats.calls == 0)
+                continue;
+
+            luabridge::LuaRef entry = luabridge::newTable(lua_state);
+            entry["calls"] = stats.calls;
+            entry["total_ms"] = stats.total_ns / 1.0e6;
+            entry["max_ms"] = stats.max_ns / 1.0e6;
+            type_table[HOOK_NAMES[hook]] = entry;
+        }
+        types[type] = type_table;
+    }
+
+    int i = 1;
+    for (const auto& [name, stats] : GetTopActors())
+    {
+        luabridge::LuaRef entry = luabridge::newTable(lua_state);
+        entry["name"] = name;
+        entry["calls"] = stats.calls;
+        entry["total_ms"] = stats.total_ns / 1.0e6;
+        entry["max_ms"] = stats.max_ns / 1.0e6;
+        actors[i++] = entry;
+    }
+
+    profile["types"] = types;
+    profile["actors"] = actors;
+    return profile;
+}
+
+void ScriptProfiler::Reset()
+{
+    type_stats.clear();
+    actor_stats.clear();
+}
+
+// One row per component type and hook, then one row per costliest actor
+bool ScriptProfiler::WriteCSV(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "error: failed to open script profile " << path << std::endl;
+        return false;
+    }
+
+    file << "scope,name,hook,calls,total_ms,mean_us,max_us\n";
+    for (const auto& [type, hooks] : type_stats)
+    {
+        for (int hook = 0; hook < HOOK_COUNT; hook++)
+        {
+            const CallStats& stats = hooks[hook];
+            if (stats.calls == 0)
+                continue;
+
+            file << "component," << type << "," << HOOK_NAMES[hook] << "," << stats.calls << ","
+                << stats.total_ns / 1.0e6 << "," << stats.total_ns / 1.0e3 / stats.calls << "," << stats.max_ns / 1.0e3 << "\n";
+        }
+    }
+
+    for (const auto& [name, stats] : GetTopActors())
+    {
+        file << "actor," << name << ",," << stats.calls << ","
+            << stats.total_ns / 1.0e6 << "," << stats.total_ns / 1.0e3 / stats.calls << "," << stats.max_ns / 1.0e3 << "\n";
+    }
+    return true;
+}
+
+void ScriptProfiler::WriteOnExit()
+{
+    WriteCSV(exit_csv_path);
+}
+
+// Actors with the highest total script time, most expensive first
+std::vector<std::pair<std::string, ScriptProfiler::CallStats>> ScriptProfiler::GetTopActors()
+{
+    std::vector<std::pair<std::string, CallStats>> top(actor_stats.begin(), actor_stats.end());
+    size_t n = std::min(top.size(), static_cast<size_t>(TOP_ACTORS));
+
+    std::partial_sort(top.begin(), top.begin() + n, top.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.second.total_ns > rhs.second.total_ns; });
+    top.resize(n);
+    return top;
+}
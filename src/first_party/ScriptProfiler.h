@@ -0,0 +1,76 @@
+#ifndef SCRIPT_PROFILER_H
+#define SCRIPT_PROFILER_H
+
+#include "ComponentManager.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Lua lifecycle call accounting per component type, hook and actor.
+// Compiled in with -DENGINE_PROFILER, otherwise PROFILE_SCRIPT expands to nothing.
+class ScriptProfiler
+{
+public:
+    static void Init();
+
+    static void Record(const std::string& type, ComponentHook hook, const std::string& actor_name, int64_t duration_ns);
+
+    static luabridge::LuaRef GetProfile();
+    static void Reset();
+    static bool WriteCSV(const std::string& path);
+
+    static int64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    struct CallStats
+    {
+        uint64_t calls = 0;
+        int64_t total_ns = 0;
+        int64_t max_ns = 0;
+
+        void Add(int64_t duration_ns);
+    };
+
+    static inline const int TOP_ACTORS = 10;
+
+    static inline std::unordered_map<std::string, std::array<CallStats, HOOK_COUNT>> type_stats;
+    static inline std::unordered_map<std::string, CallStats> actor_stats;
+
+    static inline std::string exit_csv_path;
+    static void WriteOnExit();
+
+    static std::vector<std::pair<std::string, CallStats>> GetTopActors();
+};
+
+// Times a single lifecycle call for the enclosing scope
+class ScriptZone
+{
+public:
+    ScriptZone(const std::string& zone_type, ComponentHook zone_hook, const std::string& zone_actor)
+        : type(zone_type), hook(zone_hook), actor_name(zone_actor), start_ns(ScriptProfiler::Now()) { }
+    ~ScriptZone() { ScriptProfiler::Record(type, hook, actor_name, ScriptProfiler::Now() - start_ns); }
+
+    ScriptZone(const ScriptZone&) = delete;
+    ScriptZone& operator=(const ScriptZone&) = delete;
+
+private:
+    const std::string& type;
+    ComponentHook hook;
+    const std::string& actor_name;
+    int64_t start_ns;
+};
+
+#ifdef ENGINE_PROFILER
+#define PROFILE_SCRIPT(component, hook, actor_name) ScriptZone script_zone((component).GetType(), hook, actor_name)
+#else
+#define PROFILE_SCRIPT(component, hook, actor_name)
+#endif
+
+#endif
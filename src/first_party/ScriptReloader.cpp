@@ -0,0 +1,138 @@
+#include "ScriptReloader.h"
+
+#include "ComponentDB.h"
+#include "EngineUtils.h"
+#include "Profiler.h"
+#include "SceneDB.h"
+#include "ScriptShards.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Read hot_reload from game.config and start watching the component folder
+void ScriptReloader::Init(const rapidjson::Document& doc)
+{
+#ifdef NDEBUG
+    enabled = false;
+#else
+    enabled = true;
+#endif
+    EngineUtils::GetConfigValue(doc, "hot_reload", enabled);
+    if (!enabled || !std::filesystem::exists(ComponentDB::COMPONENT_DIRECTORY))
+    {
+        enabled = false;
+        return;
+    }
+
+#ifdef __linux__
+    // Editors that save through a temporary file rename it into place
+    watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch_fd != -1 && inotify_add_watch(watch_fd, ComponentDB::COMPONENT_DIRECTORY, IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+    {
+        close(watch_fd);
+        watch_fd = -1;
+    }
+#endif
+
+    // Without a watch, remember the write times to compare against
+    if (watch_fd == -1)
+    {
+        std::unordered_set<std::string> ignored;
+        CollectWriteTimes(ignored);
+    }
+}
+
+void ScriptReloader::Poll()
+{
+    if (!enabled)
+        return;
+
+    std::unordered_set<std::string> changed;
+    if (watch_fd != -1)
+    {
+        CollectWatchEvents(changed);
+    }
+    else
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now < next_poll)
+            return;
+
+        next_poll = now + std::chrono::milliseconds(POLL_INTERVAL_MS);
+        CollectWriteTimes(changed);
+    }
+
+    if (changed.empty())
+        return;
+
+    PROFILE_ZONE("ScriptReloader::Reload");
+    for (const std::string& file_name : changed)
+        ReloadFile(file_name);
+}
+
+// Drain the inotify queue, a file saved several times since the last frame is reloaded once
+void ScriptReloader::CollectWatchEvents(std::unordered_set<std::string>& changed)
+{
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    while (true)
+    {
+        ssize_t length = read(watch_fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            return;
+
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0)
+                changed.insert(event->name);
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+#endif
+}
+
+// Add the scripts whose write time moved since the last check
+void ScriptReloader::CollectWriteTimes(std::unordered_set<std::string>& changed)
+{
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(ComponentDB::COMPONENT_DIRECTORY, error))
+    {
+        if (file.path().extension() != ".lua")
+            continue;
+
+        std::filesystem::file_time_type write_time = file.last_write_time(error);
+        if (error)
+            continue;
+
+        std::string file_name = file.path().filename().string();
+        auto it = write_times.find(file_name);
+        if (it == write_times.end() || it->second != write_time)
+        {
+            write_times[file_name] = write_time;
+            changed.insert(file_name);
+        }
+    }
+}
+
+// Types that are not loaded yet read the new source when they are. Deleted scripts keep their last version
+void ScriptReloader::ReloadFile(const std::string& file_name)
+{
+    std::filesystem::path path = std::filesystem::path(ComponentDB::COMPONENT_DIRECTORY) / file_name;
+    if (path.extension() != ".lua" || !std::filesystem::exists(path))
+        return;
+
+    std::string component_type = path.stem().string();
+    ComponentDB::AddScript(component_type, path.string());
+    if (!ComponentDB::Reload(component_type))
+        return;
+
+    int type_id = ComponentDB::FindTypeID(component_type);
+    if (type_id != -1)
+    {
+        ScriptShards::Reload(type_id);
+        SceneDB::ReregisterComponents(type_id);
+    }
+}
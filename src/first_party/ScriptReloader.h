@@ -0,0 +1,40 @@
+#ifndef SCRIPT_RELOADER_H
+#define SCRIPT_RELOADER_H
+
+#include "rapidjson/document.h"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Hot reload of component scripts. Saved scripts are merged into their loaded types between frames, so the
+// scene keeps running and its components keep their state. Watches the component folder with inotify on Linux
+// and checks write times every POLL_INTERVAL_MS elsewhere. On by default in debug builds, game.config
+// "hot_reload" turns it on or off
+class ScriptReloader
+{
+public:
+    static void Init(const rapidjson::Document& doc);
+
+    // Reload whatever was saved since the last call
+    static void Poll();
+
+private:
+    static void CollectWatchEvents(std::unordered_set<std::string>& changed);
+    static void CollectWriteTimes(std::unordered_set<std::string>& changed);
+    static void ReloadFile(const std::string& file_name);
+
+    static constexpr int POLL_INTERVAL_MS = 500;
+
+    static inline bool enabled = false;
+
+    // inotify descriptor, -1 when polling
+    static inline int watch_fd = -1;
+
+    static inline std::unordered_map<std::string, std::filesystem::file_time_type> write_times;
+    static inline std::chrono::steady_clock::time_point next_poll;
+};
+
+#endif
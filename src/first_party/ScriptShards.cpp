@@ -0,0 +1,932 @@
+#include "ScriptShards.h"
+
+#include "Actor.h"
+#include "ActorPool.h"
+#include "EngineUtils.h"
+#include "EventBus.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "SceneDB.h"
+#include "ScriptGC.h"
+#include "ScriptMemory.h"
+#include "TagDB.h"
+#include "Timestep.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+ShardInstance::ShardInstance(int shard_index, Component& component)
+    : shard(shard_index), enabled_flag(component.enabled), enabled(component.IsEnabled()), main_ref(component.component_ref)
+{
+}
+
+// A script may still hold the table, its enabled writes must not reach the component anymore
+ShardInstance::~ShardInstance()
+{
+    ScriptShards::Shard* owner = ScriptShards::shards[shard];
+    lua_State* L = owner->state;
+    lua_rawgeti(L, LUA_REGISTRYINDEX, owner->instance_cells);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+    lua_pushnil(L);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+
+    luaL_unref(L, LUA_REGISTRYINDEX, ref);
+    owner->instance_count--;
+}
+
+// One shard per job system thread, or the number set by script_shards in game.config. Games without
+// parallel types never create them
+void ScriptShards::Init(const rapidjson::Document& doc)
+{
+    int script_shards = JobSystem::GetWorkerCount() + 1;
+    EngineUtils::GetConfigValue(doc, "script_shards", script_shards);
+    configured_count = script_shards <= 0 ? 0 : std::min(script_shards, MAX_SHARDS);
+}
+
+void ScriptShards::Start()
+{
+    for (; shard_count < configured_count; shard_count++)
+    {
+        Shard* shard = new Shard();
+        shard->state = ScriptMemory::NewState();
+        luaL_openlibs(shard->state);
+        *static_cast<Shard**>(lua_getextraspace(shard->state)) = shard;
+
+        for (int* table : { &shard->subscribers, &shard->inbox, &shard->outbox })
+        {
+            lua_newtable(shard->state);
+            *table = luaL_ref(shard->state, LUA_REGISTRYINDEX);
+        }
+
+        lua_newtable(shard->state);
+        lua_createtable(shard->state, 0, 1);
+        lua_pushliteral(shard->state, "k");
+        lua_setfield(shard->state, -2, "__mode");
+        lua_setmetatable(shard->state, -2);
+        shard->instance_cells = luaL_ref(shard->state, LUA_REGISTRYINDEX);
+
+        InitFunctions(shard->state);
+        ScriptGC::AddState(shard->state, false);
+        shards[shard_count] = shard;
+    }
+}
+
+// The part of the scripting API that is safe to run off the main thread
+void ScriptShards::InitFunctions(lua_State* L)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginNamespace("Debug")
+        .addFunction("Log", &Log)
+        .endNamespace();
+
+    // Handles resolve against the scene as of the start of the phase, SetPosition lands after it
+    luabridge::getGlobalNamespace(L)
+        .beginClass<ActorHandle>("Actor")
+        .addFunction("IsValid", &ComponentManager::ActorIsValid)
+        .addFunction("__eq", &ComponentManager::ActorEquals)
+        .addFunction("GetName", &ActorGetName)
+        .addFunction("GetID", &ActorGetID)
+        .addFunction("GetTags", &ActorGetTags)
+        .addFunction("HasTags", &ComponentManager::ActorHasTags)
+        .addFunction("GetLayer", &ActorGetLayer)
+        .addFunction("GetPosition", &ActorGetPosition)
+        .addFunction("SetPosition", &ActorSetPosition)
+        .endClass();
+
+    luabridge::getGlobalNamespace(L)
+        .beginNamespace("Application")
+        .addFunction("GetFrame", &ComponentManager::GetFrame)
+        .addFunction("GetDeltaTime", &Timestep::GetDeltaTime)
+        .addFunction("GetFixedDeltaTime", &Timestep::GetFixedDeltaTime)
+        .endNamespace();
+
+    luabridge::getGlobalNamespace(L)
+        .beginNamespace("Image")
+        .addFunction("Draw", &Draw)
+        .addCFunction("DrawEx", &DrawEx)
+        .endNamespace();
+
+    luabridge::getGlobalNamespace(L)
+        .beginNamespace("Scene")
+        .addFunction("FindInRadius", &FindInRadius)
+        .addFunction("FindInRect", &FindInRect)
+        .endNamespace();
+
+    luabridge::getGlobalNamespace(L)
+        .beginNamespace("Event")
+        .addCFunction("Publish", &Publish)
+        .addCFunction("Subscribe", &Subscribe)
+        .addCFunction("Unsubscribe", &Unsubscribe)
+        .endNamespace();
+
+    ComponentManager::InitVector2(L);
+}
+
+// Put a parallel component in its shard's hook lists, building its instance if it has not run yet
+void ScriptShards::Add(Actor* actor, Component* component)
+{
+    Shard& shard = *shards[GetInstance(*component).shard];
+    if (component->HasHook(HOOK_UPDATE))
+        shard.update_hooks.Add(actor, component, component->hooks->update_interval);
+    if (component->HasHook(HOOK_LATE_UPDATE))
+        shard.late_update_hooks.Add(actor, component, component->hooks->late_update_interval);
+}
+
+// Take a component out of its shard's hook lists, the instance stays until the component drops it
+void ScriptShards::Remove(Component* component)
+{
+    if (!component->shard_instance)
+        return;
+
+    Shard& shard = *shards[component->shard_instance->shard];
+    shard.update_hooks.Remove(component);
+    shard.late_update_hooks.Remove(component);
+}
+
+void ScriptShards::Relocate(Component* component)
+{
+    if (!component->shard_instance)
+        return;
+
+    Shard& shard = *shards[component->shard_instance->shard];
+    shard.update_hooks.Relocate(component);
+    shard.late_update_hooks.Relocate(component);
+}
+
+void ScriptShards::Clear()
+{
+    for (int i = 0; i < shard_count; i++)
+    {
+        shards[i]->update_hooks.Clear();
+        shards[i]->late_update_hooks.Clear();
+    }
+}
+
+HookList& ScriptShards::GetHookList(const Component* component, ComponentHook hook)
+{
+    Shard& shard = *shards[component->shard_instance->shard];
+    return hook == HOOK_LATE_UPDATE ? shard.late_update_hooks : shard.update_hooks;
+}
+
+void ScriptShards::Run(ComponentHook hook)
+{
+    if (shard_count == 0)
+        return;
+
+    running = true;
+    JobSystem::ParallelFor(shard_count, 1, [hook](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            RunShard(*shards[i], hook);
+    });
+    running = false;
+
+    PROFILE_ZONE("ScriptShards::Flush");
+    for (int i = 0; i < shard_count; i++)
+        Flush(*shards[i]);
+}
+
+void ScriptShards::Call(Component& component, ComponentHook hook, const std::string& actor_name)
+{
+    CallInstance(component, hook, actor_name, nullptr);
+}
+
+void ScriptShards::Call(Component& component, ComponentHook hook, const std::string& actor_name, int frames)
+{
+    CallInstance(component, hook, actor_name, &frames);
+}
+
+// Copy the event into the inbox of every shard with a subscriber to it
+void ScriptShards::Forward(const std::string& event_type, luabridge::LuaRef& event_object)
+{
+    ScriptMemory::Scope memory_scope(MEMORY_EVENTS);
+
+    for (int i = 0; i < shard_count; i++)
+    {
+        Shard& shard = *shards[i];
+        if (shard.subscribed_events.count(event_type) == 0)
+            continue;
+
+        lua_State* L = shard.state;
+        lua_rawgeti(L, LUA_REGISTRYINDEX, shard.inbox);
+        lua_pushlstring(L, event_type.data(), event_type.size());
+        lua_rawseti(L, -2, 2 * shard.inbox_size + 1);
+
+        event_object.push(lua_state);
+        CopyValue(lua_state, -1, L);
+        lua_pop(lua_state, 1);
+        lua_rawseti(L, -2, 2 * shard.inbox_size + 2);
+
+        shard.inbox_size++;
+        lua_pop(L, 1);
+    }
+}
+
+// Return the component's shard instance, first building it in the least loaded shard from the fields
+// its main state table was given or inherits from its templates. Only called on the main thread when
+// the instance does not exist yet
+ShardInstance& ScriptShards::GetInstance(Component& component)
+{
+    if (component.shard_instance)
+        return *component.shard_instance;
+
+    ScriptMemory::Scope memory_scope(MEMORY_COMPONENTS);
+
+    int index = 0;
+    for (int i = 1; i < shard_count; i++)
+        if (shards[i]->instance_count < shards[index]->instance_count)
+            index = i;
+
+    Shard& shard = *shards[index];
+    lua_State* L = shard.state;
+    ShardType& type = LoadType(shard, component.type_id);
+
+    component.component_ref->push(lua_state);
+    CopyValue(lua_state, -1, L);
+    CopyInherited(lua_state, -1, L, ComponentDB::GetTypeName(component.type_id));
+    lua_pop(lua_state, 1);
+
+    auto instance = std::make_shared<ShardInstance>(index, component);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, type.metatables[instance->enabled ? 0 : 1]);
+    lua_setmetatable(L, -2);
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, shard.instance_cells);
+    lua_pushvalue(L, -2);
+    lua_pushlightuserdata(L, instance.get());
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+
+    instance->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    shard.instance_count++;
+    component.shard_instance = instance;
+    return *instance;
+}
+
+// Add the fields the main state instance at index inherits from templates to the copy on top of to. Its metatable
+// chain alternates enabled proxies and template instances up to the type table, the shard has its own type table
+// and enabled comes from the component's flag
+void ScriptShards::CopyInherited(lua_State* from, int index, lua_State* to, const std::string& type_name)
+{
+    index = lua_absindex(from, index);
+    int target = lua_gettop(to);
+    int top = lua_gettop(from);
+
+    lua_getglobal(from, type_name.c_str());
+    int type_table = lua_gettop(from);
+
+    lua_pushvalue(from, index);
+    for (int depth = 0; depth < MAX_COPY_DEPTH && lua_getmetatable(from, -1); depth++)
+    {
+        lua_pushliteral(from, "__index");
+        lua_rawget(from, -2);
+        lua_replace(from, -3);
+        lua_pop(from, 1);
+        if (!lua_istable(from, -1) || lua_rawequal(from, -1, type_table))
+            break;
+
+        // Nearer tables were copied first and win
+        lua_pushnil(from);
+        while (lua_next(from, -2))
+        {
+            bool enabled_key = lua_type(from, -2) == LUA_TSTRING && std::strcmp(lua_tostring(from, -2), "enabled") == 0;
+            if (!enabled_key && !lua_isfunction(from, -1))
+            {
+                CopyValue(from, -2, to);
+                lua_pushvalue(to, -1);
+                if (lua_rawget(to, target) == LUA_TNIL)
+                {
+                    lua_pop(to, 1);
+                    CopyValue(from, -1, to);
+                    lua_rawset(to, target);
+                }
+                else
+                {
+                    lua_pop(to, 2);
+                }
+            }
+            lua_pop(from, 1);
+        }
+    }
+
+    lua_settop(from, top);
+}
+
+// Show the component's enabled flag to the shard's scripts, main state scripts may have changed it
+void ScriptShards::SyncEnabled(Shard& shard, ShardInstance& instance, int type_id)
+{
+    instance.enabled = *instance.enabled_flag;
+
+    lua_State* L = shard.state;
+    lua_rawgeti(L, LUA_REGISTRYINDEX, instance.ref);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, shard.types[type_id].metatables[instance.enabled ? 0 : 1]);
+    lua_setmetatable(L, -2);
+    lua_pop(L, 1);
+}
+
+// Writes of new keys to a shard instance. Like ComponentDB::InstanceNewIndex, enabled updates the component's
+// flag and swaps to the matching metatable. The main state table is told when the shard is flushed
+int ScriptShards::InstanceNewIndex(lua_State* L)
+{
+    const char* key = lua_type(L, 2) == LUA_TSTRING ? lua_tostring(L, 2) : nullptr;
+    if (key == nullptr || std::strcmp(key, "enabled") != 0)
+    {
+        lua_rawset(L, 1);
+        return 0;
+    }
+
+    bool enabled = lua_toboolean(L, 3);
+    lua_pushvalue(L, 1);
+    lua_rawget(L, lua_upvalueindex(1));
+    if (ShardInstance* instance = static_cast<ShardInstance*>(lua_touserdata(L, -1)))
+    {
+        *instance->enabled_flag = enabled;
+        instance->enabled = enabled;
+        GetShard(L).enabled_changes.emplace_back(instance->main_ref, enabled);
+    }
+
+    lua_getmetatable(L, 1);
+    lua_getfield(L, -1, "__states");
+    lua_rawgeti(L, -1, enabled ? 1 : 2);
+    lua_setmetatable(L, 1);
+    lua_pop(L, 3);
+    return 0;
+}
+
+// Run a type's script in the shard on first use and pin its lifecycle functions
+ScriptShards::ShardType& ScriptShards::LoadType(Shard& shard, int type_id)
+{
+    if (static_cast<int>(shard.types.size()) <= type_id)
+        shard.types.resize(type_id + 1);
+
+    ShardType& type = shard.types[type_id];
+    if (type.loaded)
+        return type;
+
+    lua_State* L = shard.state;
+    const std::string& type_name = ComponentDB::GetTypeName(type_id);
+    if (ComponentDB::LoadScript(L, type_name) != LUA_OK || lua_pcall(L, 0, 0, 0) != LUA_OK)
+    {
+        std::cout << "problem with lua file " << type_name;
+        exit(0);
+    }
+
+    lua_getglobal(L, type_name.c_str());
+    std::fill(std::begin(type.functions), std::end(type.functions), LUA_NOREF);
+    RefFunctions(L, type);
+    type.defaults = ComponentDB::RefDefaults(L, -1);
+
+    // Instances fall back to the type table through a proxy holding enabled, with one metatable per
+    // enabled state as in the main state
+    lua_createtable(L, 0, 1);
+    lua_pushvalue(L, -2);
+    lua_setfield(L, -2, "__index");
+    int proxy_metatable = lua_gettop(L);
+
+    lua_createtable(L, 2, 0);
+    for (int i = 1; i <= 2; i++)
+    {
+        lua_createtable(L, 0, 3);
+
+        lua_createtable(L, 0, 1);
+        lua_pushboolean(L, i == 1);
+        lua_setfield(L, -2, "enabled");
+        lua_pushvalue(L, proxy_metatable);
+        lua_setmetatable(L, -2);
+        lua_setfield(L, -2, "__index");
+
+        lua_rawgeti(L, LUA_REGISTRYINDEX, shard.instance_cells);
+        lua_pushcclosure(L, &InstanceNewIndex, 1);
+        lua_setfield(L, -2, "__newindex");
+
+        lua_pushvalue(L, -2);
+        lua_setfield(L, -2, "__states");
+
+        lua_pushvalue(L, -1);
+        type.metatables[i - 1] = luaL_ref(L, LUA_REGISTRYINDEX);
+        lua_rawseti(L, -2, i);
+    }
+    lua_pop(L, 3);
+
+    type.loaded = true;
+    return type;
+}
+
+// Pin the lifecycle functions of the type table on top of L's stack in place of the ones pinned before
+void ScriptShards::RefFunctions(lua_State* L, ShardType& type)
+{
+    for (int hook = 0; hook < HOOK_COUNT; hook++)
+    {
+        luaL_unref(L, LUA_REGISTRYINDEX, type.functions[hook]);
+        lua_getfield(L, -1, HOOK_NAMES[hook]);
+        if (lua_isfunction(L, -1))
+        {
+            type.functions[hook] = luaL_ref(L, LUA_REGISTRYINDEX);
+        }
+        else
+        {
+            type.functions[hook] = LUA_NOREF;
+            lua_pop(L, 1);
+        }
+    }
+}
+
+// Between frames, instances in every shard pick up the new functions through their type table
+void ScriptShards::Reload(int type_id)
+{
+    const std::string& type_name = ComponentDB::GetTypeName(type_id);
+    for (int i = 0; i < shard_count; i++)
+    {
+        Shard& shard = *shards[i];
+        if (static_cast<int>(shard.types.size()) <= type_id || !shard.types[type_id].loaded)
+            continue;
+
+        ShardType& type = shard.types[type_id];
+        lua_State* L = shard.state;
+        ScriptMemory::Scope memory_scope(MEMORY_COMPONENTS);
+        if (ComponentDB::MergeScript(L, type_name, type.defaults))
+        {
+            lua_getglobal(L, type_name.c_str());
+            RefFunctions(L, type);
+            lua_pop(L, 1);
+        }
+
+        // Whatever the script logged or published at load
+        Flush(shard);
+    }
+}
+
+// Instances made before keep the tables they already have
+void ScriptShards::ResetTypes()
+{
+    for (int i = 0; i < shard_count; i++)
+    {
+        Shard& shard = *shards[i];
+        for (ShardType& type : shard.types)
+        {
+            if (!type.loaded)
+                continue;
+
+            for (int ref : type.functions)
+                luaL_unref(shard.state, LUA_REGISTRYINDEX, ref);
+            for (int ref : type.metatables)
+                luaL_unref(shard.state, LUA_REGISTRYINDEX, ref);
+            luaL_unref(shard.state, LUA_REGISTRYINDEX, type.defaults);
+        }
+        shard.types.clear();
+    }
+}
+
+// Call a lifecycle function with self and frames if given. Outside the parallel phases whatever the call
+// queued is replayed right away
+void ScriptShards::CallInstance(Component& component, ComponentHook hook, const std::string& actor_name, const int* frames)
+{
+    ShardInstance& instance = GetInstance(component);
+    Shard& shard = *shards[instance.shard];
+    ScriptMemory::TypeScope memory_scope(component.type_id);
+    lua_State* L = shard.state;
+
+    // Loads the type again for an instance that outlived ResetTypes
+    int function = LoadType(shard, component.type_id).functions[hook];
+    if (function == LUA_NOREF)
+        return;
+
+    if (instance.enabled != *instance.enabled_flag)
+        SyncEnabled(shard, instance, component.type_id);
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, function);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, instance.ref);
+    if (frames)
+        lua_pushinteger(L, *frames);
+
+    if (lua_pcall(L, frames ? 2 : 1, 0, 0) != LUA_OK)
+    {
+        const char* message = lua_tostring(L, -1);
+        shard.output.push_back({ actor_name, message ? message : "error object is not a string", true });
+        lua_pop(L, 1);
+    }
+
+    if (!running)
+        Flush(shard);
+}
+
+// Runs on a job system thread, touching nothing but the shard and read-only scene state
+void ScriptShards::RunShard(Shard& shard, ComponentHook hook)
+{
+    DeliverEvents(shard);
+
+    HookList& hooks = hook == HOOK_LATE_UPDATE ? shard.late_update_hooks : shard.update_hooks;
+    hooks.Run([&shard, hook](Actor* actor, Component& component, int frames) {
+        shard.drawing_layer = actor->GetLayer();
+        CallInstance(component, hook, actor->GetName(), &frames);
+    });
+    shard.drawing_layer = -1;
+}
+
+// Hand the events forwarded since the last phase to the shard's subscribers
+void ScriptShards::DeliverEvents(Shard& shard)
+{
+    if (shard.inbox_size == 0)
+        return;
+
+    lua_State* L = shard.state;
+    lua_rawgeti(L, LUA_REGISTRYINDEX, shard.inbox);
+    int inbox = lua_gettop(L);
+    int inbox_size = shard.inbox_size;
+
+    lua_newtable(L);
+    lua_rawseti(L, LUA_REGISTRYINDEX, shard.inbox);
+    shard.inbox_size = 0;
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, shard.subscribers);
+    int subscribers = lua_gettop(L);
+
+    for (int i = 0; i < inbox_size; i++)
+    {
+        lua_rawgeti(L, inbox, 2 * i + 1);
+        std::string event_type = lua_tostring(L, -1);
+        if (lua_rawget(L, subscribers) != LUA_TTABLE)
+        {
+            lua_pop(L, 1);
+            continue;
+        }
+
+        int list = lua_gettop(L);
+        lua_Integer count = static_cast<lua_Integer>(lua_rawlen(L, list));
+        for (lua_Integer j = 1; j <= count; j++)
+        {
+            if (lua_rawgeti(L, list, j) != LUA_TTABLE)
+            {
+                lua_pop(L, 1);
+                continue;
+            }
+
+            lua_rawgeti(L, -1, 2);
+            lua_rawgeti(L, -2, 1);
+            lua_rawgeti(L, inbox, 2 * i + 2);
+            if (lua_pcall(L, 2, 0, 0) != LUA_OK)
+            {
+                const char* message = lua_tostring(L, -1);
+                shard.output.push_back({ event_type, message ? message : "error object is not a string", true });
+                lua_pop(L, 1);
+            }
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+    }
+
+    lua_pop(L, 2);
+}
+
+// Replay what the shard queued on the main thread. Each queue is taken before it is replayed, since
+// replaying can call back into the shard
+void ScriptShards::Flush(Shard& shard)
+{
+    if (!shard.output.empty())
+    {
+        std::vector<Message> output;
+        std::swap(output, shard.output);
+        for (const Message& message : output)
+        {
+            if (message.error)
+                EngineUtils::ReportError(message.actor_name, message.text);
+            else
+                ComponentManager::Print(message.text);
+        }
+    }
+
+    if (!shard.moves.empty())
+    {
+        std::vector<Move> moves;
+        std::swap(moves, shard.moves);
+        for (const Move& move : moves)
+        {
+            Actor* actor = ActorPool::Resolve(move.handle);
+            if (actor && actor->IsAlive())
+                SceneDB::SetPosition(actor, move.x, move.y);
+        }
+    }
+
+    // The flag is already set, this swaps the main state table's metatable to match
+    if (!shard.enabled_changes.empty())
+    {
+        std::vector<std::pair<std::shared_ptr<luabridge::LuaRef>, bool>> changes;
+        std::swap(changes, shard.enabled_changes);
+        for (const auto& change : changes)
+            (*change.first)["enabled"] = change.second;
+    }
+
+    if (!shard.draws.empty())
+    {
+        std::vector<DrawCall> draws;
+        std::swap(draws, shard.draws);
+        for (const DrawCall& draw : draws)
+        {
+            if (draw.layer >= 0)
+                Renderer::SetDrawingLayer(draw.layer);
+
+            if (draw.simple)
+                Renderer::Draw(draw.image_name, draw.x, draw.y);
+            else
+                Renderer::DrawEx(draw.image_name, draw.x, draw.y, draw.rotation_degrees, draw.scale_x, draw.scale_y,
+                    draw.pivot_x, draw.pivot_y, draw.r, draw.g, draw.b, draw.a, draw.sorting_order);
+
+            if (draw.layer >= 0)
+                Renderer::ClearDrawingLayer();
+        }
+    }
+
+    if (shard.outbox_size > 0)
+    {
+        lua_State* L = shard.state;
+        lua_rawgeti(L, LUA_REGISTRYINDEX, shard.outbox);
+        int outbox_size = shard.outbox_size;
+
+        lua_newtable(L);
+        lua_rawseti(L, LUA_REGISTRYINDEX, shard.outbox);
+        shard.outbox_size = 0;
+
+        for (int i = 0; i < outbox_size; i++)
+        {
+            lua_rawgeti(L, -1, 2 * i + 1);
+            std::string event_type = lua_tostring(L, -1);
+            lua_pop(L, 1);
+
+            lua_rawgeti(L, -1, 2 * i + 2);
+            {
+                ScriptMemory::Scope memory_scope(MEMORY_EVENTS);
+                CopyValue(L, -1, lua_state);
+            }
+            lua_pop(L, 1);
+
+            luabridge::LuaRef event_object = luabridge::LuaRef::fromStack(lua_state);
+            EventBus::Publish(event_type, event_object);
+        }
+        lua_pop(L, 1);
+    }
+}
+
+void ScriptShards::CopyValue(lua_State* from, int index, lua_State* to)
+{
+    lua_newtable(to);
+    int copies = lua_gettop(to);
+    CopyValue(from, index, to, copies, 0);
+    lua_remove(to, copies);
+}
+
+// copies maps each source table already copied, as a light userdata, to its copy
+void ScriptShards::CopyValue(lua_State* from, int index, lua_State* to, int copies, int depth)
+{
+    index = lua_absindex(from, index);
+    switch (lua_type(from, index))
+    {
+    case LUA_TBOOLEAN:
+        lua_pushboolean(to, lua_toboolean(from, index));
+        return;
+    case LUA_TNUMBER:
+        if (lua_isinteger(from, index))
+            lua_pushinteger(to, lua_tointeger(from, index));
+        else
+            lua_pushnumber(to, lua_tonumber(from, index));
+        return;
+    case LUA_TSTRING:
+    {
+        size_t length;
+        const char* text = lua_tolstring(from, index, &length);
+        lua_pushlstring(to, text, length);
+        return;
+    }
+    case LUA_TTABLE:
+    {
+        void* source = const_cast<void*>(lua_topointer(from, index));
+        lua_pushlightuserdata(to, source);
+        if (lua_rawget(to, copies) == LUA_TTABLE)
+            return;
+        lua_pop(to, 1);
+
+        if (depth >= MAX_COPY_DEPTH || !lua_checkstack(from, 3) || !lua_checkstack(to, 4))
+            break;
+
+        lua_newtable(to);
+        lua_pushlightuserdata(to, source);
+        lua_pushvalue(to, -2);
+        lua_rawset(to, copies);
+
+        lua_pushnil(from);
+        while (lua_next(from, index))
+        {
+            CopyValue(from, -2, to, copies, depth + 1);
+            CopyValue(from, -1, to, copies, depth + 1);
+            if (lua_isnil(to, -2))
+                lua_pop(to, 2);
+            else
+                lua_rawset(to, -3);
+            lua_pop(from, 1);
+        }
+        return;
+    }
+    case LUA_TUSERDATA:
+        if (luabridge::isInstance<ActorHandle>(from, index))
+        {
+            luabridge::Stack<ActorHandle>::push(to, luabridge::Stack<ActorHandle>::get(from, index));
+            return;
+        }
+        if (luabridge::isInstance<b2Vec2>(from, index))
+        {
+            luabridge::Stack<b2Vec2>::push(to, luabridge::Stack<b2Vec2>::get(from, index));
+            return;
+        }
+        break;
+    }
+    lua_pushnil(to);
+}
+
+void ScriptShards::Log(const std::string& message, lua_State* L)
+{
+    GetShard(L).output.push_back({ "", message, false });
+}
+
+void ScriptShards::Draw(const std::string& image_name, float x, float y, lua_State* L)
+{
+    Shard& shard = GetShard(L);
+    shard.draws.push_back({ image_name, true, x, y, 0, 1, 1, 0.5f, 0.5f, 255, 255, 255, 255, 0, shard.drawing_layer });
+}
+
+// Image.DrawEx(image_name, x, y, rotation_degrees, scale_x, scale_y, pivot_x, pivot_y, r, g, b, a, sorting_order),
+// a C function since it takes more arguments than LuaBridge binds
+int ScriptShards::DrawEx(lua_State* L)
+{
+    const char* image_name = luaL_checkstring(L, 1);
+    float arguments[12];
+    for (int i = 0; i < 12; i++)
+        arguments[i] = static_cast<float>(luaL_checknumber(L, i + 2));
+
+    Shard& shard = GetShard(L);
+    shard.draws.push_back({ image_name, false, arguments[0], arguments[1], arguments[2], arguments[3],
+        arguments[4], arguments[5], arguments[6], arguments[7], arguments[8], arguments[9], arguments[10], arguments[11],
+        shard.drawing_layer });
+    return 0;
+}
+
+// Event.Publish(event_type, event_object), delivered in the main state after the phase
+int ScriptShards::Publish(lua_State* L)
+{
+    luaL_checkstring(L, 1);
+    lua_settop(L, 2);
+
+    Shard& shard = GetShard(L);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, shard.outbox);
+    lua_pushvalue(L, 1);
+    lua_rawseti(L, -2, 2 * shard.outbox_size + 1);
+    lua_pushvalue(L, 2);
+    lua_rawseti(L, -2, 2 * shard.outbox_size + 2);
+    shard.outbox_size++;
+    return 0;
+}
+
+// Event.Subscribe(event_type, component, function), takes effect from the next delivery
+int ScriptShards::Subscribe(lua_State* L)
+{
+    const char* event_type = luaL_checkstring(L, 1);
+    luaL_checktype(L, 3, LUA_TFUNCTION);
+    lua_settop(L, 3);
+
+    Shard& shard = GetShard(L);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, shard.subscribers);
+    lua_pushvalue(L, 1);
+    if (lua_rawget(L, -2) != LUA_TTABLE)
+    {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, 1);
+        lua_pushvalue(L, -2);
+        lua_rawset(L, -4);
+    }
+
+    lua_createtable(L, 2, 0);
+    lua_pushvalue(L, 2);
+    lua_rawseti(L, -2, 1);
+    lua_pushvalue(L, 3);
+    lua_rawseti(L, -2, 2);
+    lua_rawseti(L, -2, static_cast<lua_Integer>(lua_rawlen(L, -2)) + 1);
+
+    shard.subscribed_events.insert(event_type);
+    return 0;
+}
+
+// Event.Unsubscribe(event_type, component, function)
+int ScriptShards::Unsubscribe(lua_State* L)
+{
+    luaL_checkstring(L, 1);
+    lua_settop(L, 3);
+
+    Shard& shard = GetShard(L);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, shard.subscribers);
+    lua_pushvalue(L, 1);
+    if (lua_rawget(L, -2) != LUA_TTABLE)
+        return 0;
+
+    int list = lua_gettop(L);
+    lua_Integer count = static_cast<lua_Integer>(lua_rawlen(L, list));
+    for (lua_Integer j = 1; j <= count; j++)
+    {
+        lua_rawgeti(L, list, j);
+        lua_rawgeti(L, -1, 1);
+        lua_rawgeti(L, -2, 2);
+        bool match = lua_rawequal(L, -2, 2) && lua_rawequal(L, -1, 3);
+        lua_pop(L, 3);
+        if (!match)
+            continue;
+
+        for (; j < count; j++)
+        {
+            lua_rawgeti(L, list, j + 1);
+            lua_rawseti(L, list, j);
+        }
+        lua_pushnil(L);
+        lua_rawseti(L, list, count);
+        break;
+    }
+    return 0;
+}
+
+// Push a new table of the handles of found actors
+static luabridge::LuaRef HandleTable(lua_State* L, const std::vector<Actor*>& actors)
+{
+    ScriptMemory::Scope memory_scope(MEMORY_RESULTS);
+
+    lua_createtable(L, static_cast<int>(actors.size()), 0);
+    int size = 0;
+    for (Actor* a : actors)
+    {
+        luabridge::Stack<ActorHandle>::push(L, a->GetHandle());
+        lua_rawseti(L, -2, ++size);
+    }
+
+    luabridge::LuaRef table = luabridge::LuaRef::fromStack(L);
+    return table;
+}
+
+// Spatial queries see the grid as of the last rebuild, each call returns a new table
+luabridge::LuaRef ScriptShards::FindInRadius(float x, float y, float radius, lua_State* L)
+{
+    thread_local std::vector<Actor*> found;
+    found.clear();
+    SceneDB::spatial_grid.QueryRadius(x, y, radius, found);
+    return HandleTable(L, found);
+}
+
+luabridge::LuaRef ScriptShards::FindInRect(float x1, float y1, float x2, float y2, lua_State* L)
+{
+    thread_local std::vector<Actor*> found;
+    found.clear();
+    SceneDB::spatial_grid.QueryRect(std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2), found);
+    return HandleTable(L, found);
+}
+
+luabridge::LuaRef ScriptShards::ActorGetName(const ActorHandle* handle, lua_State* L)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(L);
+    return luabridge::LuaRef(L, actor->GetName());
+}
+
+luabridge::LuaRef ScriptShards::ActorGetID(const ActorHandle* handle, lua_State* L)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(L);
+    return luabridge::LuaRef(L, actor->GetID());
+}
+
+luabridge::LuaRef ScriptShards::ActorGetTags(const ActorHandle* handle, lua_State* L)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(L);
+    return luabridge::LuaRef(L, actor->GetTags());
+}
+
+luabridge::LuaRef ScriptShards::ActorGetLayer(const ActorHandle* handle, lua_State* L)
+{
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor)
+        return luabridge::LuaRef(L);
+    return luabridge::LuaRef(L, TagDB::GetLayerName(actor->GetLayer()));
+}
+
+luabridge::LuaRef ScriptShards::ActorGetPosition(const ActorHandle* handle, lua_State* L)
+{
+    float x, y;
+    Actor* actor = ActorPool::Resolve(*handle);
+    if (!actor || !SceneDB::spatial_grid.GetPosition(actor, x, y))
+        return luabridge::LuaRef(L);
+    return luabridge::LuaRef(L, b2Vec2(x, y));
+}
+
+void ScriptShards::ActorSetPosition(const ActorHandle* handle, float x, float y, lua_State* L)
+{
+    GetShard(L).moves.push_back({ *handle, x, y });
+}
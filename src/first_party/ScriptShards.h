@@ -0,0 +1,190 @@
+#ifndef SCRIPT_SHARDS_H
+#define SCRIPT_SHARDS_H
+
+#include "ActorHandle.h"
+#include "HookList.h"
+
+#include "lua/lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+#include "rapidjson/document.h"
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class Actor;
+
+// A parallel component's instance table, pinned in its shard's registry while the component holds it.
+// enabled is the state its metatable shows, brought in line with the component's flag before each call
+struct ShardInstance
+{
+    ShardInstance(int shard_index, Component& component);
+    ~ShardInstance();
+
+    int shard;
+    int ref = LUA_NOREF;
+
+    bool* enabled_flag;
+    bool enabled;
+
+    // The main state table, which follows enabled changes made in the shard
+    std::shared_ptr<luabridge::LuaRef> main_ref;
+};
+
+// Worker Lua states for component types that set parallel = true. Each such component lives in one shard,
+// built from its main state table when it first runs, and every shard runs its OnUpdate and OnLateUpdate
+// at the same time on the job system. Shards only get a read-only view of the scene, the logs, events,
+// draws and moves they make are queued and replayed on the main thread after each phase
+class ScriptShards
+{
+public:
+    static void Init(const rapidjson::Document& doc);
+    static bool IsEnabled() { return configured_count > 0; }
+
+    // Create the shards, the first time a parallel type loads
+    static void Start();
+
+    static void Add(Actor* actor, Component* component);
+    static void Remove(Component* component);
+    static void Relocate(Component* component);
+    static void Clear();
+
+    // Shard list that runs a registered parallel component's OnUpdate or OnLateUpdate
+    static HookList& GetHookList(const Component* component, ComponentHook hook);
+
+    // Run a hook on every shard at once, then replay what they queued
+    static void Run(ComponentHook hook);
+
+    // Call a parallel component's lifecycle function on the main thread, building its shard instance if needed
+    static void Call(Component& component, ComponentHook hook, const std::string& actor_name);
+    static void Call(Component& component, ComponentHook hook, const std::string& actor_name, int frames);
+
+    // Merge a hot reloaded type's script into every shard that has loaded it
+    static void Reload(int type_id);
+
+    // Drop every loaded type, the next instance of each runs the script again
+    static void ResetTypes();
+
+    // Queue an event published in the main state for the shards subscribed to it
+    static void Forward(const std::string& event_type, luabridge::LuaRef& event_object);
+
+private:
+    // A parallel type's instance metatables for enabled and disabled instances, its lifecycle functions
+    // in one shard, and the defaults a reload merges against
+    struct ShardType
+    {
+        bool loaded = false;
+        int metatables[2] = { LUA_NOREF, LUA_NOREF };
+        int defaults = LUA_NOREF;
+        int functions[HOOK_COUNT];
+    };
+
+    // Debug.Log output and script errors, printed in order
+    struct Message
+    {
+        std::string actor_name;
+        std::string text;
+        bool error;
+    };
+
+    struct Move
+    {
+        ActorHandle handle;
+        float x;
+        float y;
+    };
+
+    struct DrawCall
+    {
+        std::string image_name;
+        bool simple;
+        float x, y, rotation_degrees, scale_x, scale_y, pivot_x, pivot_y;
+        float r, g, b, a, sorting_order;
+        int layer;
+    };
+
+    struct Shard
+    {
+        lua_State* state;
+        int instance_count = 0;
+
+        // Parallel types loaded into this shard, by type id
+        std::vector<ShardType> types;
+
+        HookList update_hooks = HookList(HOOK_UPDATE);
+        HookList late_update_hooks = HookList(HOOK_LATE_UPDATE);
+
+        // Registry ref to the weak instance table -> ShardInstance light userdata map behind enabled writes
+        int instance_cells;
+
+        // Registry refs to the event type -> { { component, function }, ... } table, and to the events
+        // waiting to be delivered and the ones the shard published, both flat type, value arrays
+        int subscribers;
+        int inbox;
+        int outbox;
+        int inbox_size = 0;
+        int outbox_size = 0;
+        std::unordered_set<std::string> subscribed_events;
+
+        // Layer of the actor whose hook is running in a parallel phase, -1 otherwise
+        int drawing_layer = -1;
+
+        std::vector<Message> output;
+        std::vector<Move> moves;
+        std::vector<DrawCall> draws;
+
+        // enabled writes made in the shard, for the main state tables
+        std::vector<std::pair<std::shared_ptr<luabridge::LuaRef>, bool>> enabled_changes;
+    };
+
+    static void InitFunctions(lua_State* L);
+    static Shard& GetShard(lua_State* L) { return **static_cast<Shard**>(lua_getextraspace(L)); }
+
+    static ShardInstance& GetInstance(Component& component);
+    static ShardType& LoadType(Shard& shard, int type_id);
+    static void CopyInherited(lua_State* from, int index, lua_State* to, const std::string& type_name);
+    static void SyncEnabled(Shard& shard, ShardInstance& instance, int type_id);
+    static int InstanceNewIndex(lua_State* L);
+    static void RefFunctions(lua_State* L, ShardType& type);
+    static void CallInstance(Component& component, ComponentHook hook, const std::string& actor_name, const int* frames);
+    static void RunShard(Shard& shard, ComponentHook hook);
+    static void DeliverEvents(Shard& shard);
+    static void Flush(Shard& shard);
+
+    // Push a copy of the value at index in from onto to. Tables keep their sharing and cycles but lose
+    // their metatables. Functions, unknown userdata and tables nested deeper than MAX_COPY_DEPTH become nil
+    static void CopyValue(lua_State* from, int index, lua_State* to);
+    static void CopyValue(lua_State* from, int index, lua_State* to, int copies, int depth);
+    static constexpr int MAX_COPY_DEPTH = 16;
+
+    // Lua API inside the shards
+    static void Log(const std::string& message, lua_State* L);
+    static void Draw(const std::string& image_name, float x, float y, lua_State* L);
+    static int DrawEx(lua_State* L);
+    static int Publish(lua_State* L);
+    static int Subscribe(lua_State* L);
+    static int Unsubscribe(lua_State* L);
+    static luabridge::LuaRef FindInRadius(float x, float y, float radius, lua_State* L);
+    static luabridge::LuaRef FindInRect(float x1, float y1, float x2, float y2, lua_State* L);
+    static luabridge::LuaRef ActorGetName(const ActorHandle* handle, lua_State* L);
+    static luabridge::LuaRef ActorGetID(const ActorHandle* handle, lua_State* L);
+    static luabridge::LuaRef ActorGetTags(const ActorHandle* handle, lua_State* L);
+    static luabridge::LuaRef ActorGetLayer(const ActorHandle* handle, lua_State* L);
+    static luabridge::LuaRef ActorGetPosition(const ActorHandle* handle, lua_State* L);
+    static void ActorSetPosition(const ActorHandle* handle, float x, float y, lua_State* L);
+
+    static constexpr int MAX_SHARDS = 64;
+
+    // Shards live for the whole run like the main state, so instances released at exit can still unref
+    static inline Shard* shards[MAX_SHARDS] = {};
+    static inline int shard_count = 0;
+    static inline int configured_count = 0;
+
+    // Set while the shards run on the job system
+    static inline bool running = false;
+
+    friend struct ShardInstance;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "SpatialGrid.h"
+
+#include "Actor.h"
+
+#include <cmath>
+
+// Join the grid or update the actor's position
+void SpatialGrid::Move(Actor* actor, float x, float y)
+{
+    if (actor->spatial_slot == -1)
+    {
+        actor->spatial_slot = static_cast<int>(entries.size());
+        entries.push_back({ actor, x, y });
+    }
+    else
+    {
+        Entry& e = entries[actor->spatial_slot];
+        e.x = x;
+        e.y = y;
+    }
+    dirty = true;
+}
+
+// Leave the grid, the last entry takes the freed slot
+void SpatialGrid::Remove(Actor* actor)
+{
+    int slot = actor->spatial_slot;
+    if (slot == -1)
+        return;
+
+    // The actor may be freed before the next rebuild, queries must not reach it through the snapshot
+    if (entries[slot].placed != -1)
+        placed[entries[slot].placed].actor = nullptr;
+
+    entries[slot] = entries.back();
+    entries[slot].actor->spatial_slot = slot;
+    entries.pop_back();
+
+    actor->spatial_slot = -1;
+    dirty = true;
+}
+
+// Drop every entry and the snapshot, the actors may already be gone
+void SpatialGrid::Clear()
+{
+    for (Entry& e : entries)
+        e.actor->spatial_slot = -1;
+
+    entries.clear();
+    placed.clear();
+    bucket_start.clear();
+    bucket_mask = 0;
+    dirty = false;
+}
+
+bool SpatialGrid::GetPosition(const Actor* actor, float& x, float& y) const
+{
+    if (actor->spatial_slot == -1)
+        return false;
+
+    const Entry& e = entries[actor->spatial_slot];
+    x = e.x;
+    y = e.y;
+    return true;
+}
+
+int SpatialGrid::CellOf(float position) const
+{
+    return static_cast<int>(std::floor(position * inverse_cell_size));
+}
+
+uint32_t SpatialGrid::BucketOf(int cell_x, int cell_y) const
+{
+    return ((static_cast<uint32_t>(cell_x) * 73856093u) ^ (static_cast<uint32_t>(cell_y) * 19349663u)) & bucket_mask;
+}
+
+// Counting sort every entry into hashed cell buckets, about two buckets per entry
+void SpatialGrid::Rebuild()
+{
+    if (!dirty)
+        return;
+    dirty = false;
+
+    uint32_t bucket_count = 16;
+    while (bucket_count < entries.size() * 2)
+        bucket_count <<= 1;
+    bucket_mask = bucket_count - 1;
+
+    bucket_start.assign(bucket_count + 1, 0);
+    for (const Entry& e : entries)
+        bucket_start[BucketOf(CellOf(e.x), CellOf(e.y)) + 1]++;
+    for (uint32_t i = 0; i < bucket_count; i++)
+        bucket_start[i + 1] += bucket_start[i];
+
+    static std::vector<uint32_t> cursor;
+    cursor.assign(bucket_start.begin(), bucket_start.end() - 1);
+
+    placed.resize(entries.size());
+    for (Entry& e : entries)
+    {
+        int cell_x = CellOf(e.x);
+        int cell_y = CellOf(e.y);
+        e.placed = static_cast<int>(cursor[BucketOf(cell_x, cell_y)]++);
+        placed[e.placed] = { e.actor, e.x, e.y, cell_x, cell_y };
+    }
+}
+
+// Visit the buckets of every cell overlapping the box, or everything when that is cheaper
+template <typename Accept>
+void SpatialGrid::Query(float min_x, float min_y, float max_x, float max_y, Accept accept, std::vector<Actor*>& results) const
+{
+    if (placed.empty())
+        return;
+
+    int min_cell_x = CellOf(min_x), max_cell_x = CellOf(max_x);
+    int min_cell_y = CellOf(min_y), max_cell_y = CellOf(max_y);
+
+    double cell_count = (static_cast<double>(max_cell_x) - min_cell_x + 1) * (static_cast<double>(max_cell_y) - min_cell_y + 1);
+    if (cell_count > static_cast<double>(placed.size()))
+    {
+        for (const Placed& p : placed)
+            if (p.actor && p.actor->IsAlive() && accept(p))
+                results.push_back(p.actor);
+        return;
+    }
+
+    for (int cell_y = min_cell_y; cell_y <= max_cell_y; cell_y++)
+    {
+        for (int cell_x = min_cell_x; cell_x <= max_cell_x; cell_x++)
+        {
+            uint32_t bucket = BucketOf(cell_x, cell_y);
+            for (uint32_t i = bucket_start[bucket]; i < bucket_start[bucket + 1]; i++)
+            {
+                // Other cells can share the bucket
+                const Placed& p = placed[i];
+                if (p.cell_x != cell_x || p.cell_y != cell_y)
+                    continue;
+
+                if (p.actor && p.actor->IsAlive() && accept(p))
+                    results.push_back(p.actor);
+            }
+        }
+    }
+}
+
+void SpatialGrid::QueryRect(float min_x, float min_y, float max_x, float max_y, std::vector<Actor*>& results) const
+{
+    Query(min_x, min_y, max_x, max_y, [&](const Placed& p) {
+        return p.x >= min_x && p.x <= max_x && p.y >= min_y && p.y <= max_y;
+    }, results);
+}
+
+void SpatialGrid::QueryRadius(float x, float y, float radius, std::vector<Actor*>& results) const
+{
+    float radius_squared = radius * radius;
+    Query(x - radius, y - radius, x + radius, y + radius, [&](const Placed& p) {
+        float dx = p.x - x;
+        float dy = p.y - y;
+        return dx * dx + dy * dy <= radius_squared;
+    }, results);
+}
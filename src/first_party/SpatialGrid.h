@@ -0,0 +1,66 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <cstdint>
+#include <vector>
+
+class Actor;
+
+// Uniform grid over actor positions set from Lua. Moves are recorded immediately but the
+// cells are rebuilt in one pass per frame, so queries see positions as of the last rebuild.
+class SpatialGrid
+{
+public:
+    void SetCellSize(float size) { cell_size = size; inverse_cell_size = 1.0f / size; dirty = true; }
+
+    void Move(Actor* actor, float x, float y);
+    void Remove(Actor* actor);
+    void Clear();
+
+    bool GetPosition(const Actor* actor, float& x, float& y) const;
+
+    void Rebuild();
+
+    // Append live actors inside the area to results
+    void QueryRect(float min_x, float min_y, float max_x, float max_y, std::vector<Actor*>& results) const;
+    void QueryRadius(float x, float y, float radius, std::vector<Actor*>& results) const;
+
+private:
+    struct Entry
+    {
+        Actor* actor;
+        float x;
+        float y;
+
+        // Index of its snapshot in placed, -1 if it joined after the last rebuild
+        int placed = -1;
+    };
+
+    // Snapshot of an entry at the last rebuild, grouped by bucket. The actor is null once the entry is removed
+    struct Placed
+    {
+        Actor* actor;
+        float x;
+        float y;
+        int cell_x;
+        int cell_y;
+    };
+
+    int CellOf(float position) const;
+    uint32_t BucketOf(int cell_x, int cell_y) const;
+
+    template <typename Accept>
+    void Query(float min_x, float min_y, float max_x, float max_y, Accept accept, std::vector<Actor*>& results) const;
+
+    float cell_size = 4.0f;
+    float inverse_cell_size = 0.25f;
+
+    std::vector<Entry> entries;
+    bool dirty = false;
+
+    std::vector<Placed> placed;
+    std::vector<uint32_t> bucket_start;
+    uint32_t bucket_mask = 0;
+};
+
+#endif
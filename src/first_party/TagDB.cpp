@@ -0,0 +1,78 @@
+#include "TagDB.h"
+
+#include <iostream>
+
+// Read which layers collide with which, layers that are not listed collide with everything
+void TagDB::Init(const rapidjson::Document& doc)
+{
+    rapidjson::Value::ConstMemberIterator it = doc.FindMember("layer_collisions");
+    if (it == doc.MemberEnd() || !it->value.IsObject())
+        return;
+
+    for (rapidjson::Value::ConstMemberIterator jt = it->value.MemberBegin(); jt != it->value.MemberEnd(); jt++)
+    {
+        uint16_t mask = 0;
+        for (const rapidjson::Value& other : jt->value.GetArray())
+            mask |= static_cast<uint16_t>(1u << GetLayer(other.GetString()));
+
+        collision_masks[GetLayer(jt->name.GetString())] = mask;
+    }
+}
+
+// Return the bit for a tag, assigning the next free one on first use
+uint32_t TagDB::GetTagMask(const std::string& tag_name)
+{
+    auto it = tag_masks.find(tag_name);
+    if (it != tag_masks.end())
+        return it->second;
+
+    if (tag_masks.size() == MAX_TAGS)
+    {
+        std::cout << "error: tag " << tag_name << " exceeds the limit of " << MAX_TAGS << " tags";
+        exit(0);
+    }
+
+    uint32_t mask = 1u << tag_masks.size();
+    tag_masks[tag_name] = mask;
+    return mask;
+}
+
+// Combine a json array of tag names into one mask
+uint32_t TagDB::GetTagMask(const rapidjson::Value& tag_names)
+{
+    uint32_t mask = 0;
+    for (const rapidjson::Value& tag : tag_names.GetArray())
+        mask |= GetTagMask(tag.GetString());
+    return mask;
+}
+
+// Return the index of a layer, assigning the next free one on first use
+int TagDB::GetLayer(const std::string& layer_name)
+{
+    auto it = layer_ids.find(layer_name);
+    if (it != layer_ids.end())
+        return it->second;
+
+    if (layer_names.size() == MAX_LAYERS)
+    {
+        std::cout << "error: layer " << layer_name << " exceeds the limit of " << MAX_LAYERS << " layers";
+        exit(0);
+    }
+
+    int layer = static_cast<int>(layer_names.size());
+    layer_names.push_back(layer_name);
+    layer_ids[layer_name] = layer;
+    return layer;
+}
+
+int TagDB::FindLayer(const std::string& layer_name)
+{
+    auto it = layer_ids.find(layer_name);
+    return it == layer_ids.end() ? -1 : it->second;
+}
+
+uint32_t TagDB::GetLayerMask(const std::string& layer_name)
+{
+    int layer = FindLayer(layer_name);
+    return layer == -1 ? 0 : 1u << layer;
+}
@@ -0,0 +1,46 @@
+#ifndef TAG_DB_H
+#define TAG_DB_H
+
+#include "rapidjson/document.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// Interned actor tag bits and layer indices. Layer 0 is "default"
+class TagDB
+{
+public:
+    static inline const int MAX_TAGS = 32;
+
+    // Layers double as Box2D collision categories, which are 16 bits wide
+    static inline const int MAX_LAYERS = 16;
+
+    static void Init(const rapidjson::Document& doc);
+
+    static uint32_t GetTagMask(const std::string& tag_name);
+    static uint32_t GetTagMask(const rapidjson::Value& tag_names);
+
+    static int GetLayer(const std::string& layer_name);
+    static const std::string& GetLayerName(int layer) { return layer_names[layer]; }
+
+    // Lookups that never create a layer. -1 and an empty mask for unknown names
+    static int FindLayer(const std::string& layer_name);
+    static uint32_t GetLayerMask(const std::string& layer_name);
+
+    // Layers this layer's rigidbodies collide with, from layer_collisions in game.config
+    static uint16_t GetCollisionMask(int layer) { return collision_masks[layer]; }
+
+private:
+    static inline std::unordered_map<std::string, uint32_t> tag_masks;
+    static inline std::unordered_map<std::string, int> layer_ids = { { "default", 0 } };
+    static inline std::vector<std::string> layer_names = { "default" };
+    static inline uint16_t collision_masks[MAX_LAYERS] = {
+        0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+        0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF
+    };
+};
+
+#endif
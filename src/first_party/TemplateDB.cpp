@@ -2,9 +2,15 @@
 
 #include "EngineUtils.h"
 
+#include <algorithm>
+
 void TemplateDB::LoadAll()
 {
     template_map.clear();
+
+    // The plans' metatable refs belonged to the previous Lua state, which is already gone
+    spawn_plans.clear();
+    pool_sizes.clear();
     const std::string directory_path = "resources/actor_templates";
     if (std::filesystem::exists(directory_path))
     {
@@ -24,6 +30,40 @@ Actor* TemplateDB::GetTemplate(const std::string& template_name)
     return template_map[template_name].get();
 }
 
+// Return the compiled plan for a template, compiling it on first use
+const SpawnPlan& TemplateDB::GetSpawnPlan(const std::string& template_name)
+{
+    auto it = spawn_plans.find(template_name);
+    if (it == spawn_plans.end())
+    {
+        CompileSpawnPlan(template_name);
+        it = spawn_plans.find(template_name);
+    }
+    return it->second;
+}
+
+// Resolve everything an instance shares with its template once, so spawning only builds the instance tables
+void TemplateDB::CompileSpawnPlan(const std::string& template_name)
+{
+    Actor* source = GetTemplate(template_name);
+
+    SpawnPlan& plan = spawn_plans[template_name];
+    plan.source = source;
+    plan.pool_size = pool_sizes[template_name];
+    plan.steps.reserve(source->components.size());
+
+    for (const Component& component : source->components)
+    {
+        SpawnPlan::ComponentStep& step = plan.steps.emplace_back();
+        step.is_cpp = !component.component_ref->isTable();
+        if (step.is_cpp)
+            continue;
+
+        step.enabled_metatable = ComponentDB::RefParentMetatable(*component.component_ref, true);
+        step.disabled_metatable = ComponentDB::RefParentMetatable(*component.component_ref, false);
+    }
+}
+
 std::vector<std::string> TemplateDB::ListAllTemplateTypes()
 {
     static std::vector<std::string> list;
@@ -50,6 +90,10 @@ void TemplateDB::CreateTemplate(const std::string& template_name)
     rapidjson::Document doc;
     EngineUtils::ReadJsonFile(path, doc);
 
-    std::unique_ptr<Actor> new_template = std::make_unique<Actor>(doc);
+    int pooled = 0;
+    EngineUtils::GetConfigValue(doc, "pooled", pooled);
+    pool_sizes[template_name] = std::max(pooled, 0);
+
+    std::unique_ptr<Actor> new_template = std::make_unique<Actor>(ActorHandle(), doc);
     template_map[template_name] = std::move(new_template);
 }
\ No newline at end of file
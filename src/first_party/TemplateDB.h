@@ -7,15 +7,40 @@
 #include <unordered_map>
 
 
+// A template compiled for instantiation. Components are in the template's key order,
+// so step i builds an instance of source->components[i]
+struct SpawnPlan
+{
+    struct ComponentStep
+    {
+        // Built-in components are copy-constructed, script components get a bare table
+        bool is_cpp = false;
+
+        // Registry refs to the shared metatables for an enabled and a disabled instance
+        int enabled_metatable = LUA_NOREF;
+        int disabled_metatable = LUA_NOREF;
+    };
+
+    const Actor* source = nullptr;
+    std::vector<ComponentStep> steps;
+
+    // Released instances kept for reuse, from the template's "pooled" field. 0 disables pooling
+    int pool_size = 0;
+};
+
 class TemplateDB
 {
 public:
     static void LoadAll();
     static Actor* GetTemplate(const std::string& template_name);
+    static const SpawnPlan& GetSpawnPlan(const std::string& template_name);
     static std::vector<std::string> ListAllTemplateTypes();
 private:
     static void CreateTemplate(const std::string& template_name);
+    static void CompileSpawnPlan(const std::string& template_name);
     static inline std::unordered_map<std::string, std::unique_ptr<Actor>> template_map;
+    static inline std::unordered_map<std::string, SpawnPlan> spawn_plans;
+    static inline std::unordered_map<std::string, int> pool_sizes;
 };
 
 #endif
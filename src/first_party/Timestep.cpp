@@ -0,0 +1,53 @@
+#include "Timestep.h"
+
+#include "EngineUtils.h"
+#include "Helper.h"
+
+#include <algorithm>
+
+// Read simulation rate from game.config
+void Timestep::Init(const rapidjson::Document& doc)
+{
+    float fixed_update_rate = 60.0f;
+    int max_fixed_steps = 5;
+    EngineUtils::GetConfigValue(doc, "fixed_update_rate", fixed_update_rate);
+    EngineUtils::GetConfigValue(doc, "max_fixed_steps", max_fixed_steps);
+
+    if (fixed_update_rate <= 0.0f)
+        fixed_update_rate = 60.0f;
+    if (max_fixed_steps < 1)
+        max_fixed_steps = 1;
+
+    fixed_delta_time = 1.0f / fixed_update_rate;
+    max_delta_time = fixed_delta_time * max_fixed_steps;
+    delta_time = fixed_delta_time;
+}
+
+// Measure time since the last frame and bank it for the fixed steps
+void Timestep::BeginFrame()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    // Replayed and headless sessions simulate exactly one step per frame
+    if (lockstep || Helper::_autograder_mode || first_frame)
+        delta_time = fixed_delta_time;
+    else
+        delta_time = std::min(std::chrono::duration<float>(now - last_frame_time).count(), max_delta_time);
+
+    last_frame_time = now;
+    first_frame = false;
+    accumulator += delta_time;
+}
+
+// Return true while a whole fixed step is owed, leave the remainder as the interpolation factor
+bool Timestep::StepFixed()
+{
+    if (accumulator < fixed_delta_time)
+    {
+        interpolation_alpha = accumulator / fixed_delta_time;
+        return false;
+    }
+
+    accumulator -= fixed_delta_time;
+    return true;
+}
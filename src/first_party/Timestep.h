@@ -0,0 +1,35 @@
+#ifndef TIMESTEP_H
+#define TIMESTEP_H
+
+#include "rapidjson/document.h"
+
+#include <chrono>
+
+class Timestep
+{
+public:
+    static void Init(const rapidjson::Document& doc);
+
+    static void SetLockstep(bool enabled) { lockstep = enabled; }
+
+    static void BeginFrame();
+    static bool StepFixed();
+
+    static float GetDeltaTime() { return delta_time; }
+    static float GetFixedDeltaTime() { return fixed_delta_time; }
+    static float GetInterpolationAlpha() { return interpolation_alpha; }
+
+private:
+    static inline float fixed_delta_time = 1.0f / 60.0f;
+    static inline float delta_time = 1.0f / 60.0f;
+    static inline float max_delta_time = 5.0f / 60.0f;
+
+    static inline float accumulator = 0.0f;
+    static inline float interpolation_alpha = 1.0f;
+
+    static inline std::chrono::steady_clock::time_point last_frame_time;
+    static inline bool first_frame = true;
+    static inline bool lockstep = false;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "UpdateLOD.h"
+
+#include "Actor.h"
+#include "HookList.h"
+#include "Rigidbody.h"
+#include "ScriptShards.h"
+#include "SpatialGrid.h"
+
+// Append component, entries are unordered so removal can swap in the last one
+void UpdateLOD::Add(Actor* actor, Component* component)
+{
+    if (component->lod_slot != -1)
+        return;
+
+    component->lod_slot = static_cast<int>(entries.size());
+    component->lod_far = false;
+    entries.push_back({ actor, component });
+}
+
+void UpdateLOD::Remove(Component* component)
+{
+    int slot = component->lod_slot;
+    if (slot == -1)
+        return;
+
+    entries[slot] = entries.back();
+    entries[slot].component->lod_slot = slot;
+    entries.pop_back();
+
+    component->lod_slot = -1;
+    component->lod_far = false;
+}
+
+void UpdateLOD::Relocate(Component* component)
+{
+    int slot = component->lod_slot;
+    if (slot != -1)
+        entries[slot].component = component;
+}
+
+void UpdateLOD::Clear()
+{
+    for (Entry& e : entries)
+    {
+        e.component->lod_slot = -1;
+        e.component->lod_far = false;
+    }
+
+    entries.clear();
+    cursor = 0;
+}
+
+// Measure the next slice of entries and move the ones that changed sides. A component has to come
+// 10% inside its distance to count as near again, so ones on the edge do not flip every check
+void UpdateLOD::Refresh(const SpatialGrid& grid, const b2Vec2& focus, HookList& update_hooks, HookList& late_update_hooks)
+{
+    if (entries.empty())
+        return;
+
+    size_t slice = (entries.size() + CHECK_INTERVAL - 1) / CHECK_INTERVAL;
+    for (size_t i = 0; i < slice; i++)
+    {
+        cursor = (cursor + 1) % entries.size();
+        Entry& e = entries[cursor];
+        const ComponentHooks* hooks = e.component->hooks;
+
+        bool far = false;
+        b2Vec2 position;
+        if (FindPosition(grid, e.actor, position))
+        {
+            float distance = hooks->lod_distance * (e.component->lod_far ? 0.9f : 1.0f);
+            far = (position - focus).LengthSquared() > distance * distance;
+        }
+
+        if (far == e.component->lod_far)
+            continue;
+
+        // Parallel components sit in their shard's lists
+        HookList& updates = e.component->IsParallel() ? ScriptShards::GetHookList(e.component, HOOK_UPDATE) : update_hooks;
+        HookList& late_updates = e.component->IsParallel() ? ScriptShards::GetHookList(e.component, HOOK_LATE_UPDATE) : late_update_hooks;
+
+        e.component->lod_far = far;
+        updates.SetInterval(e.component, far ? hooks->far_update_interval : hooks->update_interval);
+        late_updates.SetInterval(e.component, far ? hooks->far_update_interval : hooks->late_update_interval);
+    }
+}
+
+bool UpdateLOD::FindPosition(const SpatialGrid& grid, Actor* actor, b2Vec2& position)
+{
+    float x, y;
+    if (grid.GetPosition(actor, x, y))
+    {
+        position.Set(x, y);
+        return true;
+    }
+
+    if (Rigidbody* rigidbody = actor->GetRigidbody())
+    {
+        position = rigidbody->GetPosition();
+        return true;
+    }
+    return false;
+}
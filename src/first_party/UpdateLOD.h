@@ -0,0 +1,44 @@
+#ifndef UPDATE_LOD_H
+#define UPDATE_LOD_H
+
+#include "ComponentManager.h"
+
+#include "box2d/box2d.h"
+
+#include <vector>
+
+class Actor;
+class HookList;
+class SpatialGrid;
+
+// Distance based update rates for component types that set lod_distance. Each frame a slice of the
+// entries is measured against the focus point, and components that crossed their type's distance are
+// moved between their near and far update buckets
+class UpdateLOD
+{
+public:
+    void Add(Actor* actor, Component* component);
+    void Remove(Component* component);
+    void Relocate(Component* component);
+    void Clear();
+
+    void Refresh(const SpatialGrid& grid, const b2Vec2& focus, HookList& update_hooks, HookList& late_update_hooks);
+
+    // Position an actor is measured from, its spatial grid position or else its Rigidbody's
+    static bool FindPosition(const SpatialGrid& grid, Actor* actor, b2Vec2& position);
+
+private:
+    struct Entry
+    {
+        Actor* actor;
+        Component* component;
+    };
+
+    // Every entry is measured once per this many frames
+    static constexpr size_t CHECK_INTERVAL = 8;
+
+    std::vector<Entry> entries;
+    size_t cursor = 0;
+};
+
+#endif
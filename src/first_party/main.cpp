@@ -3,6 +3,7 @@
 int main(int argc, char* argv[])
 {
     Engine engine;
+    engine.ParseArguments(argc, argv);
     engine.GameLoop();
 
     return 0;